@@ -0,0 +1,202 @@
+#include "atlas.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <SDL3_image/SDL_image.h>
+
+#include "pack.hpp"
+#include "textures.hpp"
+
+const AtlasRegion* TextureAtlas::add(const std::string& filepath)
+{
+    if (const auto itr = regionsByPath.find(filepath); itr != regionsByPath.end())
+    {
+        return itr->second;
+    }
+
+    AutoRelease<SDL_Surface*> surface = loadSheet(filepath);
+    AtlasRegion* region = &regions.emplace_back();
+    regionsByPath.emplace(filepath, region);
+    pending.push_back({std::move(surface), region});
+    return region;
+}
+
+void TextureAtlas::build(SDL_Renderer* renderer)
+{
+    if (pending.empty())
+    {
+        return;
+    }
+    // the pages are about to be replaced, so the sheets already in them are read again
+    if (!pages.empty())
+    {
+        for (const auto& [filepath, region]: regionsByPath)
+        {
+            if (std::ranges::none_of(
+                    pending, [region](const Pending& p)
+                    {
+                        return p.region == region;
+                    }))
+            {
+                pending.push_back({loadSheet(filepath), region});
+            }
+        }
+    }
+
+    const int pageSize = static_cast<int>(std::min<Sint64>(
+            MAX_PAGE_SIZE,
+            SDL_GetNumberProperty(
+                    SDL_GetRendererProperties(renderer),
+                    SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, MAX_PAGE_SIZE)));
+
+    // shelf packing, tallest sheets first so every shelf wastes little height
+    std::vector<Pending*> order;
+    order.reserve(pending.size());
+    for (Pending& p: pending)
+    {
+        order.push_back(&p);
+    }
+    std::ranges::sort(
+            order, [](const Pending* a, const Pending* b)
+            {
+                const SDL_Surface* sa = a->surface;
+                const SDL_Surface* sb = b->surface;
+                return sa->h > sb->h;
+            });
+
+    struct Placement
+    {
+        Pending* pending;
+        int page, x, y;
+    };
+    std::vector<Placement> placements;
+    placements.reserve(order.size());
+    std::vector<SDL_Point> pageExtents{{0, 0}};
+    int x = 0, y = 0, shelfHeight = 0;
+    for (Pending* p: order)
+    {
+        const SDL_Surface* sheet = p->surface;
+        const int w = sheet->w + PADDING;
+        const int h = sheet->h + PADDING;
+        if (w > pageSize || h > pageSize)
+        {
+            throw std::runtime_error("Sprite sheet does not fit in an atlas page");
+        }
+        if (x + w > pageSize) // next shelf
+        {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + h > pageSize) // next page
+        {
+            x = y = shelfHeight = 0;
+            pageExtents.push_back({0, 0});
+        }
+        const int page = static_cast<int>(pageExtents.size()) - 1;
+        placements.push_back({p, page, x, y});
+        pageExtents[page].x = std::max(pageExtents[page].x, x + w);
+        pageExtents[page].y = std::max(pageExtents[page].y, y + h);
+        x += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+
+    std::vector<AutoRelease<SDL_Texture*>> newPages;
+    for (int page = 0; page < static_cast<int>(pageExtents.size()); ++page)
+    {
+        AutoRelease<SDL_Surface*> surface = {
+                SDL_CreateSurface(
+                        pageExtents[page].x, pageExtents[page].y, SDL_PIXELFORMAT_RGBA32),
+                SDL_DestroySurface
+        };
+        if (surface == nullptr)
+        {
+            throw std::runtime_error("Failed to create atlas page");
+        }
+        for (const Placement& placement: placements)
+        {
+            if (placement.page != page)
+            {
+                continue;
+            }
+            SDL_Surface* sheet = placement.pending->surface;
+            // copy pixels and alpha as they are
+            SDL_SetSurfaceBlendMode(sheet, SDL_BLENDMODE_NONE);
+            const SDL_Rect dst{placement.x, placement.y, sheet->w, sheet->h};
+            SDL_BlitSurface(sheet, nullptr, surface, &dst);
+        }
+
+        // converted once to what the renderer draws from, with premultiplied alpha
+        AutoRelease<SDL_Texture*> tex = textures::create(renderer, surface);
+        SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
+
+        for (const Placement& placement: placements)
+        {
+            if (placement.page != page)
+            {
+                continue;
+            }
+            SDL_Surface* sheet = placement.pending->surface;
+            *placement.pending->region = {
+                    .texture = tex,
+                    .rect = {
+                            static_cast<float>(placement.x), static_cast<float>(placement.y),
+                            static_cast<float>(sheet->w), static_cast<float>(sheet->h)
+                    },
+                    .opaque = textures::isOpaque(sheet)
+            };
+        }
+        newPages.push_back(std::move(tex));
+    }
+
+    // old pages are destroyed here, nothing points to them anymore
+    pages.swap(newPages);
+    pending.clear();
+}
+
+bool TextureAtlas::reload(SDL_Renderer* renderer, const std::string& filepath)
+{
+    const auto itr = regionsByPath.find(filepath);
+    if (itr == regionsByPath.end())
+    {
+        return false;
+    }
+    AtlasRegion* region = itr->second;
+    AutoRelease<SDL_Surface*> surface = loadSheet(filepath);
+    const SDL_Surface* sheet = surface;
+    if (sheet->w != static_cast<int>(region->rect.w) ||
+        sheet->h != static_cast<int>(region->rect.h))
+    {
+        pending.push_back({std::move(surface), region});
+        build(renderer);
+        return true;
+    }
+
+    // same size, the new pixels go where the old ones were
+    AutoRelease<SDL_Surface*> converted = textures::convertFor(region->texture, surface);
+    region->opaque = textures::isOpaque(surface);
+    const SDL_Surface* pixels = converted;
+    const SDL_Rect rect{
+            static_cast<int>(region->rect.x), static_cast<int>(region->rect.y), pixels->w,
+            pixels->h
+    };
+    SDL_UpdateTexture(region->texture, &rect, pixels->pixels, pixels->pitch);
+    return true;
+}
+
+AutoRelease<SDL_Surface*> TextureAtlas::loadSheet(const std::string& filepath)
+{
+    AutoRelease<SDL_Surface*> surface = {
+            IMG_Load_IO(assets::open(filepath), true), SDL_DestroySurface
+    };
+    if (surface == nullptr)
+    {
+        throw std::runtime_error("Failed to load " + filepath);
+    }
+    return surface;
+}
+
+size_t TextureAtlas::pageCount() const
+{
+    return pages.size();
+}
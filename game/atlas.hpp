@@ -0,0 +1,51 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL3/SDL.h>
+#include <autorelease/AutoRelease.hpp>
+
+// A sprite sheet packed into an atlas page
+struct AtlasRegion
+{
+    SDL_Texture* texture{}; // atlas page, set by TextureAtlas::build()
+    SDL_FRect rect{};       // sheet position inside the page
+    bool opaque{};          // no transparent pixels, can be drawn without blending
+};
+
+// Packs sprite sheets into a few large textures at load time, so sprites from
+// different sheets share a texture and end up in the same draw call.
+class TextureAtlas
+{
+public:
+
+    // the returned region is filled in by build() and stays valid for the atlas lifetime,
+    // adding the same file twice returns the same region
+    const AtlasRegion* add(const std::string& filepath);
+    // packs the sheets added since the last build, together with every sheet packed before
+    void build(SDL_Renderer* renderer);
+    // reads a sheet from disk again, false if it isn't in the atlas. Regions stay valid,
+    // a sheet that changed size makes the whole atlas be packed again.
+    bool reload(SDL_Renderer* renderer, const std::string& filepath);
+    [[nodiscard]] size_t pageCount() const;
+
+private:
+
+    // space left around every sheet, so neighbours never bleed into each other
+    static constexpr int PADDING = 1;
+    static constexpr int MAX_PAGE_SIZE = 2048;
+
+    struct Pending
+    {
+        AutoRelease<SDL_Surface*> surface;
+        AtlasRegion* region;
+    };
+
+    std::deque<AtlasRegion> regions{};
+    std::unordered_map<std::string, AtlasRegion*> regionsByPath{};
+    std::vector<Pending> pending{};
+    std::vector<AutoRelease<SDL_Texture*>> pages{};
+
+    static AutoRelease<SDL_Surface*> loadSheet(const std::string& filepath);
+};
@@ -0,0 +1,235 @@
+#include "audio.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+#include "pack.hpp"
+
+Sound::Sound(
+        MIX_Mixer* mixer, const std::string& filepath, const LoadPolicy policy,
+        const int maxVoices, const int priority)
+    : policy(policy), filepath(filepath), maxVoices(maxVoices), priority(priority)
+{
+    if (policy == LoadPolicy::streamed)
+    {
+        return;
+    }
+
+    // decode everything now, for the mixer this will play on, so playing it is just a copy
+    audio = {MIX_LoadAudio_IO(mixer, assets::open(filepath), true, true), MIX_DestroyAudio};
+    if (!audio)
+    {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
+        throw std::runtime_error("Error");
+    }
+
+    SDL_AudioSpec spec{};
+    const Sint64 frames = MIX_GetAudioDuration(audio);
+    if (frames > 0 && MIX_GetAudioFormat(audio, &spec))
+    {
+        residentBytes = frames * spec.channels * SDL_AUDIO_BYTESIZE(spec.format);
+    }
+}
+
+bool Sound::attach(MIX_Track* track) const
+{
+    if (policy == LoadPolicy::predecoded)
+    {
+        return MIX_SetTrackAudio(track, audio);
+    }
+
+    // the track owns the stream and reads it in chunks as it plays
+    SDL_IOStream* io = assets::open(filepath);
+    if (!io)
+    {
+        return false;
+    }
+    return MIX_SetTrackIOStream(track, io, true);
+}
+
+void AudioSystem::init(MIX_Mixer* mixer, const int voiceCount, const int startsPerFrame)
+{
+    this->mixer = mixer;
+    this->startsPerFrame = startsPerFrame;
+
+    voices.resize(voiceCount);
+    for (Voice& voice: voices)
+    {
+        voice.track = {MIX_CreateTrack(mixer), MIX_DestroyTrack};
+        if (!voice.track)
+        {
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
+            throw std::runtime_error("Error");
+        }
+    }
+
+    musicTrack = {MIX_CreateTrack(mixer), MIX_DestroyTrack};
+    if (!musicTrack)
+    {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
+        throw std::runtime_error("Error");
+    }
+    musicOptions = {SDL_CreateProperties(), SDL_DestroyProperties};
+    if (!musicOptions)
+    {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
+        throw std::runtime_error("Error");
+    }
+    SDL_SetNumberProperty(musicOptions, MIX_PROP_PLAY_LOOPS_NUMBER, -1);
+}
+
+Sound_ID AudioSystem::load(
+        const std::string& filepath, const LoadPolicy policy, const int maxVoices,
+        const int priority)
+{
+    const Uint64 start = SDL_GetPerformanceCounter();
+    sounds.emplace_back(mixer, filepath, policy, maxVoices, priority);
+    loadMs[static_cast<int>(policy)] += (SDL_GetPerformanceCounter() - start) * 1000.0f /
+                                        SDL_GetPerformanceFrequency();
+    return sounds.size() - 1;
+}
+
+void AudioSystem::logLoadStats() const
+{
+    for (const LoadPolicy policy: {LoadPolicy::predecoded, LoadPolicy::streamed})
+    {
+        int count = 0;
+        size_t bytes = 0;
+        for (const Sound& sound: sounds)
+        {
+            if (sound.policy == policy)
+            {
+                ++count;
+                bytes += sound.residentBytes;
+            }
+        }
+        SDL_Log(
+                "Audio %s: %d sounds, loaded in %.2f ms, %zu KiB resident",
+                policy == LoadPolicy::predecoded ? "predecoded" : "streamed", count,
+                loadMs[static_cast<int>(policy)], bytes / 1024);
+    }
+}
+
+bool AudioSystem::playMusic(const Sound_ID sound, const float gain)
+{
+    return sounds.at(sound).attach(musicTrack) &&
+           MIX_SetTrackGain(musicTrack, gain) &&
+           MIX_PlayTrack(musicTrack, musicOptions);
+}
+
+void AudioSystem::process(std::vector<SoundEvent>& events, const SDL_FRect& listener)
+{
+    stats = {};
+    if (events.empty())
+    {
+        return;
+    }
+    stats.requested = static_cast<int>(events.size());
+
+    // full volume on screen, fading out past its edges; panned across its width and hard left
+    // or right beyond it
+    const glm::vec2 centre{listener.x + listener.w / 2, listener.y + listener.h / 2};
+    const glm::vec2 halfSize{listener.w / 2, listener.h / 2};
+    audible.clear();
+    for (const SoundEvent& event: events)
+    {
+        const glm::vec2 offset = event.position - centre;
+        const float outside = glm::length(glm::max(glm::abs(offset) - halfSize, 0.0f));
+        const float gain = 1.0f - outside / AUDIBLE_DISTANCE;
+        if (gain < MIN_AUDIBLE_GAIN)
+        {
+            ++stats.culled;
+            continue;
+        }
+        audible.push_back(
+                {event.sound, sounds.at(event.sound).priority, gain,
+                 std::clamp(offset.x / halfSize.x, -1.0f, 1.0f)});
+    }
+
+    // stable, so equally important and loud sounds keep the order they were queued in
+    std::ranges::stable_sort(
+            audible, [](const Audible& a, const Audible& b)
+            {
+                return a.priority != b.priority ? a.priority > b.priority : a.gain > b.gain;
+            });
+
+    frameStarts.assign(sounds.size(), 0);
+    const Uint64 begin = SDL_GetPerformanceCounter();
+    // one lock for the whole batch instead of one per call
+    MIX_LockMixer(mixer);
+    for (const Audible& a: audible)
+    {
+        // more copies of a sound than it may play at once would only restart each other
+        if (stats.started >= startsPerFrame || frameStarts[a.sound] >= sounds[a.sound].maxVoices)
+        {
+            ++stats.overBudget;
+            continue;
+        }
+        ++frameStarts[a.sound];
+        stats.started += start(a);
+    }
+    MIX_UnlockMixer(mixer);
+    stats.mixerMs = (SDL_GetPerformanceCounter() - begin) * 1000.0f /
+                    SDL_GetPerformanceFrequency();
+
+    events.clear();
+}
+
+const AudioSystem::Stats& AudioSystem::getStats() const
+{
+    return stats;
+}
+
+bool AudioSystem::start(const Audible& request)
+{
+    const Sound_ID sound_id = request.sound;
+    const Sound& sound = sounds.at(sound_id);
+
+    Voice* freeVoice = nullptr;
+    Voice* oldestSame = nullptr; // oldest voice already playing this sound
+    Voice* oldestLower = nullptr; // oldest voice we are allowed to steal
+    int playing = 0;
+    for (Voice& voice: voices)
+    {
+        if (!MIX_TrackPlaying(voice.track))
+        {
+            freeVoice = freeVoice ? freeVoice : &voice;
+            continue;
+        }
+        if (voice.sound == sound_id)
+        {
+            ++playing;
+            if (!oldestSame || voice.startedAt < oldestSame->startedAt)
+            {
+                oldestSame = &voice;
+            }
+        }
+        if (voice.priority <= sound.priority &&
+            (!oldestLower || voice.startedAt < oldestLower->startedAt))
+        {
+            oldestLower = &voice;
+        }
+    }
+
+    // at the limit, restart the oldest copy; otherwise a free voice, otherwise steal one
+    Voice* voice = playing >= sound.maxVoices ? oldestSame : freeVoice ? freeVoice : oldestLower;
+    if (!voice)
+    {
+        return false;
+    }
+
+    voice->sound = sound_id;
+    voice->priority = sound.priority;
+    voice->startedAt = ++playCount;
+    // equal power, scaled so a sound in the middle plays as loud as an unpanned one, and
+    // clamped so a panned one never goes over full scale on either side and clips
+    const float angle = (request.pan + 1.0f) * std::numbers::pi_v<float> / 4;
+    const MIX_StereoGains gains{
+            std::min(std::numbers::sqrt2_v<float> * std::cos(angle), 1.0f),
+            std::min(std::numbers::sqrt2_v<float> * std::sin(angle), 1.0f)
+    };
+    return sound.attach(voice->track) && MIX_SetTrackGain(voice->track, request.gain) &&
+           MIX_SetTrackStereo(voice->track, &gains) && MIX_PlayTrack(voice->track, 0);
+}
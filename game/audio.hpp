@@ -0,0 +1,108 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <SDL3_mixer/SDL_mixer.h>
+#include <autorelease/AutoRelease.hpp>
+
+typedef size_t Sound_ID;
+
+enum class LoadPolicy
+{
+    // decoded to PCM at load time, nothing left to decode on play
+    predecoded,
+    // nothing kept in memory, decoded from disk on the audio thread while playing
+    streamed
+};
+
+struct Sound
+{
+    LoadPolicy policy{};
+    std::string filepath{};
+    AutoRelease<MIX_Audio*> audio{}; // null when streamed
+    size_t residentBytes{};          // estimated memory held by audio
+    int maxVoices{};                 // copies of this sound that may play at the same time
+    int priority{}; // may steal voices from sounds with lower or equal priority
+
+    Sound(
+            MIX_Mixer* mixer, const std::string& filepath, LoadPolicy policy, int maxVoices,
+            int priority);
+    // sets this sound as the input of track
+    bool attach(MIX_Track* track) const;
+};
+
+// a request to play a sound, queued by gameplay code during the frame
+struct SoundEvent
+{
+    Sound_ID sound{};
+    glm::vec2 position{}; // in the map, where it was made
+};
+
+// sounds fade out over this distance past the edge of the viewport
+constexpr float AUDIBLE_DISTANCE = 320.0f;
+// and quieter than this aren't played at all
+constexpr float MIN_AUDIBLE_GAIN = 0.05f;
+
+// Plays sound effects on a fixed pool of mixer tracks created up front.
+// Gameplay code only queues SoundEvents, they are started together once per frame
+// under a single mixer lock, limited per sound and stealing voices by priority.
+// Each sound is attenuated by its distance from the viewport and panned by where it is across
+// it; the ones too far away to hear never reach the mixer, and at most startsPerFrame of the
+// rest are started in a frame, the most important and loudest first.
+class AudioSystem
+{
+public:
+
+    // what the last process() call did
+    struct Stats
+    {
+        int requested{};
+        int culled{};     // too far from the viewport to hear
+        int overBudget{}; // over startsPerFrame or maxVoices of their sound in the frame
+        int started{};
+        float mixerMs{}; // with the mixer locked
+    };
+
+    void init(MIX_Mixer* mixer, int voiceCount, int startsPerFrame);
+    Sound_ID load(const std::string& filepath, LoadPolicy policy, int maxVoices, int priority);
+    // logs load time and resident memory of the loaded sounds, per policy
+    void logLoadStats() const;
+    // music loops on its own track, outside the voice pool
+    bool playMusic(Sound_ID sound, float gain);
+    // starts the queued sounds heard from listener, in map coordinates, and clears the queue
+    void process(std::vector<SoundEvent>& events, const SDL_FRect& listener);
+    [[nodiscard]] const Stats& getStats() const;
+
+private:
+
+    struct Voice
+    {
+        AutoRelease<MIX_Track*> track{};
+        Sound_ID sound{};
+        int priority{};
+        Uint64 startedAt{};
+    };
+
+    // a sound that can be heard, waiting for its turn in the budget
+    struct Audible
+    {
+        Sound_ID sound{};
+        int priority{};
+        float gain{};
+        float pan{}; // -1 left to 1 right
+    };
+
+    MIX_Mixer* mixer{};
+    std::vector<Sound> sounds{};
+    float loadMs[2]{}; // per LoadPolicy
+    std::vector<Voice> voices{};
+    AutoRelease<MIX_Track*> musicTrack{};
+    AutoRelease<SDL_PropertiesID> musicOptions{};
+    Uint64 playCount{}; // orders voices by age
+    int startsPerFrame{};
+    std::vector<Audible> audible{};  // kept between frames, so processing doesn't allocate
+    std::vector<int> frameStarts{}; // per sound, in this process() call
+    Stats stats{};
+
+    bool start(const Audible& request);
+};
@@ -0,0 +1,1458 @@
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+#include <autorelease/AutoRelease.hpp>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "game.hpp"
+#include "memory.hpp"
+#include "netplay.hpp"
+#include "pack.hpp"
+#include "snapshot.hpp"
+#include "spritebatch.hpp"
+#include "textures.hpp"
+#include "tiles.hpp"
+#include "tmx.hpp"
+
+// Benchmarks of the game's hot paths, run without a display or audio device.
+//
+//     sdl3-demo-bench [--filter=<text>] [--min-time=<seconds>] [--out=<file>] [--map=<file>]
+//                     [--load-map=<file>]
+//
+// Results are written as JSON in Google Benchmark's layout, so its tools/compare.py can
+// diff two runs. data/ is loaded from the working directory, like the game does.
+// --map replaces original.tmx in everything but the tmx::loadMap cases, so a map made by
+// sdl3-demo-mapgen can be used to see how the game scales. --load-map adds a tmx::loadMap
+// case for a map of any size. On Linux every case reports its peak resident memory.
+
+namespace
+{
+    constexpr float FRAME_TIME = 1.0f / 60.0f;
+    constexpr int MAX_ITERATIONS = 1000000;
+    const std::string ORIGINAL_MAP = "data/maps/original.tmx";
+
+    struct Result
+    {
+        std::string name{};
+        int64_t iterations{};
+        double realNs{}, cpuNs{}; // per iteration
+        std::vector<std::pair<std::string, double>> counters{};
+        std::string error{};
+    };
+
+    // branch mispredictions of this thread in user code, on Linux where perf events are allowed
+    class BranchMisses
+    {
+    public:
+
+        BranchMisses()
+        {
+#ifdef __linux__
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        }
+
+        BranchMisses(const BranchMisses&) = delete;
+        BranchMisses& operator=(const BranchMisses&) = delete;
+
+        ~BranchMisses()
+        {
+#ifdef __linux__
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+#endif
+        }
+
+        [[nodiscard]] bool available() const
+        {
+            return fd >= 0;
+        }
+
+        void enable(const bool on) const
+        {
+#ifdef __linux__
+            if (fd >= 0)
+            {
+                ioctl(fd, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+            }
+#endif
+        }
+
+        [[nodiscard]] uint64_t count() const
+        {
+            uint64_t value = 0;
+#ifdef __linux__
+            if (fd >= 0 && read(fd, &value, sizeof(value)) != sizeof(value))
+            {
+                value = 0;
+            }
+#endif
+            return value;
+        }
+
+    private:
+
+        int fd = -1;
+    };
+
+    // Times one benchmark. The body loops on next(), everything between two calls is measured
+    // unless it is wrapped in pause()/resume().
+    class Bench
+    {
+    public:
+
+        explicit Bench(const double minTime) : minTime(minTime)
+        {
+        }
+
+        bool next()
+        {
+            pause();
+            const double seconds = static_cast<double>(realTicks) / SDL_GetPerformanceFrequency();
+            if (iterations > 0 && (seconds >= minTime || iterations >= MAX_ITERATIONS))
+            {
+                return false;
+            }
+            ++iterations;
+            resume();
+            return true;
+        }
+
+        void pause()
+        {
+            if (!running)
+            {
+                return;
+            }
+            realTicks += SDL_GetPerformanceCounter() - realStart;
+            cpuTicks += std::clock() - cpuStart;
+            allocations += memory::allocationCount() - allocationStart;
+            branchMisses.enable(false);
+            running = false;
+        }
+
+        void resume()
+        {
+            running = true;
+            branchMisses.enable(true);
+            allocationStart = memory::allocationCount();
+            cpuStart = std::clock();
+            realStart = SDL_GetPerformanceCounter();
+        }
+
+        // work done by one iteration, reported as items_per_second
+        void setItems(const int64_t itemsPerIteration)
+        {
+            items = itemsPerIteration;
+        }
+
+        void counter(const std::string& name, const double value)
+        {
+            counters.emplace_back(name, value);
+        }
+
+        void skip(const std::string& message)
+        {
+            error = message;
+        }
+
+        [[nodiscard]] Result result(const std::string& name) const
+        {
+            Result r{.name = name, .iterations = iterations, .counters = counters, .error = error};
+            if (iterations == 0)
+            {
+                return r;
+            }
+            const double realSeconds = static_cast<double>(realTicks) /
+                                       SDL_GetPerformanceFrequency();
+            const double cpuSeconds = static_cast<double>(cpuTicks) / CLOCKS_PER_SEC;
+            r.realNs = realSeconds * 1e9 / iterations;
+            r.cpuNs = cpuSeconds * 1e9 / iterations;
+            if (items > 0)
+            {
+                r.counters.emplace_back("items_per_second", items * iterations / realSeconds);
+            }
+            r.counters.emplace_back(
+                    "allocs_per_iter", static_cast<double>(allocations) / iterations);
+            if (branchMisses.available())
+            {
+                r.counters.emplace_back(
+                        "branch_misses_per_iter",
+                        static_cast<double>(branchMisses.count()) / iterations);
+            }
+            return r;
+        }
+
+    private:
+
+        double minTime;
+        int64_t iterations{};
+        bool running{};
+        Uint64 realStart{}, realTicks{};
+        std::clock_t cpuStart{}, cpuTicks{};
+        size_t allocationStart{}, allocations{};
+        BranchMisses branchMisses{};
+        int64_t items{};
+        std::vector<std::pair<std::string, double>> counters{};
+        std::string error{};
+    };
+
+    struct Case
+    {
+        std::string name;
+        std::function<void(Bench&)> run;
+    };
+
+    // SDL, a software renderer drawing into a surface and a mixer that is never played
+    struct Headless
+    {
+        SDLState state{};
+        AutoRelease<SDL_Surface*> target;
+        std::array<bool, SDL_SCANCODE_COUNT> keys{}; // nothing is ever pressed
+
+        bool init()
+        {
+            SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "dummy");
+            SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+            state.sdl_init = {SDL_Init(SDL_INIT_VIDEO), [](const int&)
+            {
+                SDL_Quit();
+            }};
+            if (!state.sdl_init)
+            {
+                return false;
+            }
+
+            // same sizes as the game window
+            state.width = 1600;
+            state.height = 900;
+            target = {
+                    SDL_CreateSurface(state.width, state.height, SDL_PIXELFORMAT_XRGB8888),
+                    SDL_DestroySurface
+            };
+            if (target == nullptr)
+            {
+                return false;
+            }
+            state.renderer = {SDL_CreateSoftwareRenderer(target), SDL_DestroyRenderer};
+            if (!state.renderer)
+            {
+                return false;
+            }
+            state.logW = 640;
+            state.logH = 320;
+            SDL_SetRenderLogicalPresentation(
+                    state.renderer, state.logW, state.logH, SDL_LOGICAL_PRESENTATION_LETTERBOX);
+            state.keys = keys.data();
+
+            state.mix_init = {MIX_Init(), [](const bool&)
+            {
+                MIX_Quit();
+            }};
+            if (!state.mix_init)
+            {
+                return false;
+            }
+            const SDL_AudioSpec spec{SDL_AUDIO_F32, 2, 48000};
+            state.mixer = {MIX_CreateMixer(&spec), MIX_DestroyMixer};
+            return state.mixer != nullptr;
+        }
+    };
+
+    GameState newGame(const Headless& headless, const Resources& res)
+    {
+        GameState gs(
+                headless.state.logW, headless.state.logH,
+                res.map->mapHeight * res.map->tileHeight);
+        createTiles(&headless.state, &gs, &res);
+        updateViewport(&gs, &res);
+        return gs;
+    }
+
+    // spread over the viewport at the player's height, so all of them are awake
+    void spawnEnemies(GameState& gs, const Resources& res, const int count)
+    {
+        const int layer = gs.playerLayer();
+        const float y = gs.player().position.y;
+        const int width = static_cast<int>(gs.mapViewport.w);
+        for (int i = 0; i < count; ++i)
+        {
+            const float x = gs.mapViewport.x + static_cast<float>(i * 17 % width);
+            spawnObject(&gs, layer, createEnemy(&res, {x, y}));
+        }
+    }
+
+    // keeps count bullets in flight, fired both ways from the player
+    void refillBullets(GameState& gs, const Resources& res, GameObject& shooter, const int count)
+    {
+        int active = 0;
+        for (const GameObject& bullet: gs.bullets)
+        {
+            active += bullet.get<BulletData>().state != BulletState::inactive;
+        }
+        shooter.position = gs.player().position;
+        for (; active < count; ++active)
+        {
+            shooter.direction = -shooter.direction;
+            fireBullet(&gs, &res, shooter);
+        }
+        gs.events.clear();
+        gs.soundEvents.clear();
+        gs.particleEvents.clear();
+    }
+
+    // the queues GameState reserves, a tick that outgrew them allocated
+    bool queuesGrew(const GameState& gs)
+    {
+        return gs.events.capacity() > GameState::EVENT_CAPACITY ||
+               gs.soundEvents.capacity() > GameState::EFFECT_CAPACITY ||
+               gs.particleEvents.capacity() > GameState::EFFECT_CAPACITY;
+    }
+
+    // what a player holds at a tick, changing every few ticks the same way in every run
+    PlayerInput scriptedInput(const int player, const int frame)
+    {
+        Uint64 state = (frame / 12 + 1) * 2654435761u + player * 40503u;
+        return {static_cast<uint8_t>(SDL_rand_r(&state, 16))};
+    }
+
+    // a size in bytes from /proc/self/status, e.g. "VmRSS:", 0 where unknown
+    size_t procStatusBytes(const std::string_view field)
+    {
+        size_t kiloBytes = 0;
+#ifdef __linux__
+        if (std::FILE* status = std::fopen("/proc/self/status", "r"))
+        {
+            char line[256];
+            while (std::fgets(line, sizeof(line), status) != nullptr)
+            {
+                if (std::string_view(line).starts_with(field))
+                {
+                    kiloBytes = std::strtoull(line + field.size(), nullptr, 10);
+                }
+            }
+            std::fclose(status);
+        }
+#endif
+        return kiloBytes * 1024;
+    }
+
+    // the peak resident set size since the last resetPeakRss()
+    size_t peakRss()
+    {
+        return procStatusBytes("VmHWM:");
+    }
+
+    size_t currentRss()
+    {
+        return procStatusBytes("VmRSS:");
+    }
+
+    // drops the files from the OS page cache, so the next read comes from the disk.
+    // false where that isn't possible.
+    bool evictFromPageCache(const std::vector<std::string>& paths)
+    {
+#ifdef __linux__
+        for (const std::string& path: paths)
+        {
+            const int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                return false;
+            }
+            const bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+            close(fd);
+            if (!evicted)
+            {
+                return false;
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void resetPeakRss()
+    {
+#ifdef __linux__
+        // writing 5 to clear_refs drops the peak back to the current size
+        if (std::FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w"))
+        {
+            std::fputs("5", clearRefs);
+            std::fclose(clearRefs);
+        }
+#endif
+    }
+
+    std::vector<Case> makeCases(Headless& headless, Resources& res, const std::string& extraMap)
+    {
+        std::vector<Case> cases;
+
+        // Resources::load at startup, from the files under data/ and from data.pack.
+        // Cold drops them from the page cache first, like the first start after a reboot.
+        std::vector<std::string> looseFiles;
+        for (const auto& item: std::filesystem::recursive_directory_iterator("data"))
+        {
+            if (item.is_regular_file())
+            {
+                looseFiles.push_back(item.path().string());
+            }
+        }
+        for (const bool packed: {false, true})
+        {
+            for (const bool cold: {true, false})
+            {
+                cases.push_back(
+                        {
+                                std::format(
+                                        "startup/resources/{}/{}", packed ? "pack" : "loose",
+                                        cold ? "cold" : "warm"),
+                                [&headless, looseFiles, packed, cold](Bench& b)
+                                {
+                                    const std::vector<std::string> files =
+                                            packed
+                                                ? std::vector<std::string>{assets::DEFAULT_PACK}
+                                                : looseFiles;
+                                    if (packed && !std::filesystem::exists(assets::DEFAULT_PACK))
+                                    {
+                                        b.skip("No data.pack, build the pack_data target");
+                                        return;
+                                    }
+                                    while (b.next())
+                                    {
+                                        b.pause();
+                                        // unmapped, or the pages would stay cached
+                                        assets::unmount();
+                                        if (cold && !evictFromPageCache(files))
+                                        {
+                                            b.skip("Can't drop files from the page cache");
+                                            return;
+                                        }
+                                        auto res = std::make_unique<Resources>();
+                                        b.resume();
+
+                                        if (packed)
+                                        {
+                                            assets::mount(assets::DEFAULT_PACK);
+                                        }
+                                        res->load(&headless.state, ORIGINAL_MAP);
+
+                                        b.pause();
+                                        res.reset();
+                                        b.resume();
+                                    }
+                                    assets::unmount();
+                                    b.counter("files", static_cast<double>(files.size()));
+                                }
+                        });
+            }
+        }
+
+        std::vector<std::pair<std::string, std::string>> maps = {
+                {"small", "data/maps/smallmap.tmx"},
+                {"original", ORIGINAL_MAP},
+                {"big", "data/maps/bigmap.tmx"},
+        };
+        if (!extraMap.empty())
+        {
+            maps.emplace_back(std::filesystem::path(extraMap).stem().string(), extraMap);
+        }
+        for (const auto& [name, path]: maps)
+        {
+            cases.push_back(
+                    {
+                            "tmx::loadMap/" + name, [path](Bench& b)
+                            {
+                                int64_t tiles = 0;
+                                while (b.next())
+                                {
+                                    const std::unique_ptr<tmx::Map> map = tmx::loadMap(path);
+                                    if (!map)
+                                    {
+                                        b.skip("Failed to load " + path);
+                                        return;
+                                    }
+                                    tiles = map->mapWidth * map->mapHeight;
+                                }
+                                b.setItems(tiles);
+                            }
+                    });
+        }
+
+        // every iteration moves the target to the next cell a player can stand on, left to
+        // right through the map, so each one is a full recompute
+        for (const auto& [name, path]: maps)
+        {
+            cases.push_back(
+                    {
+                            "flowfield/recompute/" + name, [path](Bench& b)
+                            {
+                                const std::unique_ptr<tmx::Map> map = tmx::loadMap(path);
+                                if (!map)
+                                {
+                                    b.skip("Failed to load " + path);
+                                    return;
+                                }
+                                const tmx::Layer* level = nullptr;
+                                for (const auto& layer: map->layers)
+                                {
+                                    const auto* tiles = std::get_if<tmx::Layer>(&layer);
+                                    level = tiles && tiles->name == "Level" ? tiles : level;
+                                }
+                                if (level == nullptr)
+                                {
+                                    b.skip("No Level layer in " + path);
+                                    return;
+                                }
+
+                                const int w = map->mapWidth, h = map->mapHeight;
+                                std::vector<glm::ivec2> cells;
+                                for (int c = 0; c < w; ++c)
+                                {
+                                    for (int r = 0; r + 1 < h; ++r)
+                                    {
+                                        if (!level->data[r * w + c] && level->data[(r + 1) * w + c])
+                                        {
+                                            cells.emplace_back(c, r);
+                                        }
+                                    }
+                                }
+                                if (cells.size() < 2)
+                                {
+                                    b.skip("Nowhere to stand in " + path);
+                                    return;
+                                }
+
+                                FlowField field(
+                                        w, h, map->tileWidth, map->tileHeight, level->data,
+                                        ENEMY_CHASE_STEPS);
+                                size_t next = 0;
+                                while (b.next())
+                                {
+                                    field.setTarget(cells[next]);
+                                    next = (next + 1) % cells.size();
+                                }
+                                b.counter("standable_cells", static_cast<double>(cells.size()));
+                            }
+                    });
+        }
+
+        // the tileset comes from the cache after the first iteration
+        cases.push_back(
+                {
+                        "tmx::loadMap/original/cached-tilesets", [](Bench& b)
+                        {
+                            tmx::TileSetCache tileSetCache;
+                            while (b.next())
+                            {
+                                if (!tmx::loadMap(ORIGINAL_MAP, tileSetCache))
+                                {
+                                    b.skip("Failed to load " + ORIGINAL_MAP);
+                                    return;
+                                }
+                            }
+                        }
+                });
+
+        cases.push_back(
+                {
+                        "createTiles", [&headless, &res](Bench& b)
+                        {
+                            GameState gs;
+                            while (b.next())
+                            {
+                                b.pause();
+                                gs = GameState(
+                                        headless.state.logW, headless.state.logH,
+                                        res.map->mapHeight * res.map->tileHeight);
+                                b.resume();
+                                createTiles(&headless.state, &gs, &res);
+                            }
+                            b.setItems(res.map->mapWidth * res.map->mapHeight);
+                        }
+                });
+
+        // one updateGame() with every enemy awake and the bullets refilled before each, the
+        // player alone in the level for enemies:0/bullets:0
+        for (const int enemies: {0, 100, 1000})
+        {
+            for (const int bullets: {0, 64})
+            {
+                cases.push_back(
+                        {
+                                std::format(
+                                        "updateGame/enemies:{}/bullets:{}", enemies, bullets),
+                                [&headless, &res, enemies, bullets](Bench& b)
+                                {
+                                    GameState gs = newGame(headless, res);
+                                    spawnEnemies(gs, res, enemies);
+                                    GameObject shooter;
+                                    while (b.next())
+                                    {
+                                        b.pause();
+                                        refillBullets(gs, res, shooter, bullets);
+                                        b.resume();
+                                        updateGame(&headless.state, &gs, &res, FRAME_TIME);
+                                        gs.soundEvents.clear();
+                                        gs.particleEvents.clear();
+                                    }
+                                    b.setItems(1 + gs.awakeEnemies + bullets);
+                                    b.counter("rect_tests", gs.collisionTests);
+                                }
+                        });
+            }
+        }
+
+        // all of updateGame() with players, enemies and bullets mixed in the layers, the
+        // players shooting all the time. Each type goes through its own loop, see
+        // branch_misses_per_iter.
+        for (const int enemies: {100, 1000})
+        {
+            cases.push_back(
+                    {
+                            std::format("updateGame/mixed/players:2/enemies:{}", enemies),
+                            [&headless, &res, enemies](Bench& b)
+                            {
+                                GameState gs = newGame(headless, res);
+                                addPlayers(&gs, &res, 2);
+                                spawnEnemies(gs, res, enemies);
+                                int frame = 0;
+                                while (b.next())
+                                {
+                                    for (int p = 0; p < 2; ++p)
+                                    {
+                                        gs.inputs[p] = scriptedInput(p, frame);
+                                        gs.inputs[p].buttons |= PlayerInput::shoot;
+                                    }
+                                    ++frame;
+                                    updateGame(&headless.state, &gs, &res, FRAME_TIME);
+                                    gs.soundEvents.clear();
+                                    gs.particleEvents.clear();
+                                }
+                                if (queuesGrew(gs))
+                                {
+                                    b.skip("An event queue outgrew GameState's reserve");
+                                    return;
+                                }
+                                int64_t bullets = 0;
+                                for (const GameObject& bullet: gs.bullets)
+                                {
+                                    bullets += bullet.get<BulletData>().state !=
+                                               BulletState::inactive;
+                                }
+                                b.setItems(2 + gs.awakeEnemies + bullets);
+                                b.counter("awake_enemies", gs.awakeEnemies);
+                                b.counter("rect_tests", gs.collisionTests);
+                                b.counter("contact_scans", gs.contactScans);
+                            }
+                    });
+        }
+
+        // the same with an enemy spawned and one destroyed every tick, the layer of dynamic
+        // objects changing under the contact caches. They only hold tiles, so tile_changes
+        // stays 0 and contact_scans per tick only adds the scans of the enemies just spawned
+        // while they drop into place.
+        cases.push_back(
+                {
+                        "updateGame/churn/players:2/enemies:100",
+                        [&headless, &res](Bench& b)
+                        {
+                            GameState gs = newGame(headless, res);
+                            addPlayers(&gs, &res, 2);
+                            const int layer = gs.playerLayer();
+                            const float y = gs.player().position.y;
+                            const int width = static_cast<int>(gs.mapViewport.w);
+                            std::vector<ObjectHandle> enemies;
+                            for (int i = 0; i < 100; ++i)
+                            {
+                                const float x = gs.mapViewport.x +
+                                                static_cast<float>(i * 17 % width);
+                                enemies.push_back(
+                                        spawnObject(&gs, layer, createEnemy(&res, {x, y})));
+                            }
+                            // the first update indexes the layers
+                            updateGame(&headless.state, &gs, &res, FRAME_TIME);
+                            const uint32_t version = gs.layersVersion;
+                            int frame = 0;
+                            int64_t scans = 0;
+                            while (b.next())
+                            {
+                                for (int p = 0; p < 2; ++p)
+                                {
+                                    gs.inputs[p] = scriptedInput(p, frame);
+                                    gs.inputs[p].buttons |= PlayerInput::shoot;
+                                }
+                                ObjectHandle& oldest = enemies[frame % enemies.size()];
+                                destroyObject(&gs, oldest);
+                                const float x = gs.mapViewport.x +
+                                                static_cast<float>(frame * 17 % width);
+                                oldest = spawnObject(&gs, layer, createEnemy(&res, {x, y}));
+                                ++frame;
+                                updateGame(&headless.state, &gs, &res, FRAME_TIME);
+                                scans += gs.contactScans;
+                                gs.soundEvents.clear();
+                                gs.particleEvents.clear();
+                            }
+                            b.setItems(2 + gs.awakeEnemies);
+                            b.counter(
+                                    "contact_scans",
+                                    static_cast<double>(scans) / std::max(frame, 1));
+                            b.counter("tile_changes", gs.layersVersion - version);
+                        }
+                });
+
+        // enemies all killed ten seconds before timing starts. Their corpses are gone by
+        // then, so enemies:1000 should cost what enemies:0 does.
+        for (const int enemies: {0, 1000})
+        {
+            cases.push_back(
+                    {
+                            std::format("updateGame/corpses/enemies:{}", enemies),
+                            [&headless, &res, enemies](Bench& b)
+                            {
+                                GameState gs = newGame(headless, res);
+                                spawnEnemies(gs, res, enemies);
+                                for (auto& layer: gs.layers)
+                                {
+                                    for (GameObject& obj: layer)
+                                    {
+                                        if (obj.type() == ObjectType::enemy)
+                                        {
+                                            obj.get<EnemyData>().state = EnemyState::dead;
+                                            obj.texture = res.texEnemyDie;
+                                            obj.currentAnimation = res.ANIM_ENEMY_DIE;
+                                        }
+                                    }
+                                }
+                                for (int frame = 0; frame < 10 * 60; ++frame)
+                                {
+                                    updateGame(&headless.state, &gs, &res, FRAME_TIME);
+                                }
+                                while (b.next())
+                                {
+                                    updateGame(&headless.state, &gs, &res, FRAME_TIME);
+                                }
+                                b.counter("objects", static_cast<double>(gs.registry.size()));
+                            }
+                    });
+        }
+
+        // the whole simulation state in and out of a flat buffer, as rewind does every tick
+        for (const int enemies: {0, 100, 1000})
+        {
+            cases.push_back(
+                    {
+                            std::format("snapshot/capture/enemies:{}", enemies),
+                            [&headless, &res, enemies](Bench& b)
+                            {
+                                GameState gs = newGame(headless, res);
+                                spawnEnemies(gs, res, enemies);
+                                Snapshot snapshot;
+                                while (b.next())
+                                {
+                                    snapshot.capture(gs, res);
+                                }
+                                b.counter("bytes", static_cast<double>(snapshot.size()));
+                            }
+                    });
+            cases.push_back(
+                    {
+                            std::format("snapshot/restore/enemies:{}", enemies),
+                            [&headless, &res, enemies](Bench& b)
+                            {
+                                GameState gs = newGame(headless, res);
+                                spawnEnemies(gs, res, enemies);
+                                Snapshot snapshot;
+                                snapshot.capture(gs, res);
+                                while (b.next())
+                                {
+                                    if (!snapshot.restore(gs, res))
+                                    {
+                                        b.skip("Snapshot doesn't fit the game");
+                                        return;
+                                    }
+                                }
+                                b.counter("bytes", static_cast<double>(snapshot.size()));
+                            }
+                    });
+        }
+
+        // the worst rollback: back to the oldest snapshot kept and forward again, two players,
+        // capturing the snapshot and taking the checksum of every tick the way
+        // RollbackSession::advance() does
+        for (const int enemies: {0, 100, 1000})
+        {
+            cases.push_back(
+                    {
+                            std::format(
+                                    "rollback/resimulate/ticks:{}/enemies:{}",
+                                    RollbackSession::MAX_ROLLBACK, enemies),
+                            [&headless, &res, enemies](Bench& b)
+                            {
+                                GameState gs = newGame(headless, res);
+                                addPlayers(&gs, &res, 2);
+                                spawnEnemies(gs, res, enemies);
+                                std::array<Snapshot, RollbackSession::MAX_ROLLBACK> snapshots;
+                                snapshots[0].capture(gs, res);
+                                while (b.next())
+                                {
+                                    if (!snapshots[0].restore(gs, res))
+                                    {
+                                        b.skip("Snapshot doesn't fit the game");
+                                        return;
+                                    }
+                                    for (int f = 0; f < RollbackSession::MAX_ROLLBACK; ++f)
+                                    {
+                                        if (f > 0)
+                                        {
+                                            snapshots[f].capture(gs, res);
+                                        }
+                                        gs.inputs[0] = scriptedInput(0, f);
+                                        gs.inputs[1] = scriptedInput(1, f);
+                                        updateViewport(&gs, &res);
+                                        updateGame(
+                                                &headless.state, &gs, &res,
+                                                RollbackSession::TICK_TIME);
+                                        checksum(gs);
+                                        gs.soundEvents.clear();
+                                        gs.particleEvents.clear();
+                                    }
+                                }
+                                b.setItems(RollbackSession::MAX_ROLLBACK);
+                            }
+                    });
+        }
+
+        // two sessions playing each other over UDP on loopback, the clock is simulated so a
+        // match runs as fast as it can. Both ends must agree on every confirmed tick.
+        const LinkConditions links[] = {{0, 0, 0}, {50, 10, 0.05f}, {100, 30, 0.1f}};
+        for (const LinkConditions& link: links)
+        {
+            cases.push_back(
+                    {
+                            std::format(
+                                    "rollback/loopback/latency:{}/jitter:{}/loss:{}",
+                                    link.latencyMs, link.jitterMs, link.loss),
+                            [&headless, &res, link](Bench& b)
+                            {
+                                constexpr int TICKS = 600;
+                                double matches = 0, rollbacks = 0, stalls = 0;
+                                int compared = 0, desyncs = 0;
+                                float maxRollbackMs = 0;
+                                while (b.next())
+                                {
+                                    b.pause();
+                                    GameState games[2] = {
+                                            newGame(headless, res), newGame(headless, res)
+                                    };
+                                    RollbackSession sessions[2] = {{0, 1}, {1, 0}};
+                                    for (int p = 0; p < 2; ++p)
+                                    {
+                                        addPlayers(&games[p], &res, 2);
+                                        if (!sessions[p].open(0, link))
+                                        {
+                                            b.skip("Failed to open a UDP socket");
+                                            return;
+                                        }
+                                    }
+                                    sessions[0].setPeer("127.0.0.1", sessions[1].localPort());
+                                    sessions[1].setPeer("127.0.0.1", sessions[0].localPort());
+                                    b.resume();
+
+                                    // a stalled end repeats the tick, so stop on ticks reached
+                                    int checked = 0;
+                                    for (int t = 0; t < 10 * TICKS &&
+                                                    (sessions[0].getStats().frame < TICKS ||
+                                                     sessions[1].getStats().frame < TICKS);
+                                         ++t)
+                                    {
+                                        const uint64_t now = t * 1000 / 60;
+                                        for (int p = 0; p < 2; ++p)
+                                        {
+                                            const int frame = sessions[p].getStats().frame;
+                                            sessions[p].advance(
+                                                    &headless.state, &games[p], &res,
+                                                    scriptedInput(p, frame), now);
+                                            games[p].soundEvents.clear();
+                                            games[p].particleEvents.clear();
+                                        }
+                                        // checksums are only kept for a few ticks
+                                        for (; checked < TICKS; ++checked)
+                                        {
+                                            const uint64_t a =
+                                                    sessions[0].confirmedChecksum(checked);
+                                            const uint64_t c =
+                                                    sessions[1].confirmedChecksum(checked);
+                                            if (a == 0 || c == 0)
+                                            {
+                                                break;
+                                            }
+                                            ++compared;
+                                            desyncs += a != c;
+                                        }
+                                    }
+
+                                    b.pause();
+                                    ++matches;
+                                    for (const RollbackSession& session: sessions)
+                                    {
+                                        rollbacks += session.getStats().rollbacks;
+                                        stalls += session.getStats().stalls;
+                                        maxRollbackMs = std::max(
+                                                maxRollbackMs, session.getStats().maxRollbackMs);
+                                    }
+                                    b.resume();
+                                }
+                                b.setItems(2 * TICKS);
+                                matches = std::max(matches, 1.0);
+                                b.counter("rollbacks_per_match", rollbacks / matches);
+                                b.counter("stalls_per_match", stalls / matches);
+                                b.counter("max_rollback_ms", maxRollbackMs);
+                                b.counter("checked_ticks", compared);
+                                b.counter("desyncs", desyncs);
+                            }
+                    });
+        }
+
+        // one table update per frame, whatever the number of tiles showing these gids
+        for (const int gids: {16, 1024})
+        {
+            cases.push_back(
+                    {
+                            std::format("tiles/animate/gids:{}", gids),
+                            [&res, gids](Bench& b)
+                            {
+                                const std::vector<const AtlasRegion*>& regions =
+                                        res.tileSetTextures.front().textures;
+                                tmx::TileSet tileSet(1, gids, 32, 32, 0);
+                                TileSetTextures textures{.firstgid = 1};
+                                for (int id = 0; id < gids; ++id)
+                                {
+                                    tileSet.tiles.push_back({.id = id});
+                                    textures.textures.push_back(regions[id % regions.size()]);
+                                    for (int f = 0; f < 4; ++f)
+                                    {
+                                        tileSet.tiles.back().animation.push_back(
+                                                {(id + f) % gids, 100 + f * 50});
+                                    }
+                                }
+                                TileAnimations animations;
+                                animations.load({&tileSet, 1}, {&textures, 1});
+                                while (b.next())
+                                {
+                                    animations.update(FRAME_TIME);
+                                }
+                                b.setItems(gids);
+                            }
+                    });
+        }
+
+        // a steady cloud of live particles spread over the viewport, drifting but never dying
+        const ParticleEmitter cloud{
+                .count = 1000, .spread = SDL_PI_F, .speedMin = 5, .speedMax = 20,
+                .lifetimeMin = 1e6f, .lifetimeMax = 1e6f, .gravity = 1, .sizeStart = 2,
+                .sizeEnd = 2, .colorStart = {1.0f, 0.8f, 0.4f, 1.0f},
+                .colorEnd = {1.0f, 0.8f, 0.4f, 1.0f}
+        };
+        const auto fillParticles = [cloud](ParticleSystem& particles, const int count)
+        {
+            for (int i = 0; i < count; i += cloud.count)
+            {
+                particles.emit(
+                        cloud, 0, {static_cast<float>(i * 7 % 640), static_cast<float>(i % 320)},
+                        1);
+            }
+            particles.update(0);
+        };
+        for (const int live: {10000, 50000, 100000})
+        {
+            cases.push_back(
+                    {
+                            std::format("particles/update/live:{}", live),
+                            [fillParticles, live](Bench& b)
+                            {
+                                ParticleSystem particles;
+                                fillParticles(particles, live);
+                                while (b.next())
+                                {
+                                    particles.update(FRAME_TIME);
+                                }
+                                b.setItems(particles.getStats().particles);
+                            }
+                    });
+        }
+        // within a 60 Hz frame budget this has to stay under 16.7 ms
+        for (const int live: {10000, 50000})
+        {
+            cases.push_back(
+                    {
+                            std::format("particles/frame/software/live:{}", live),
+                            [&headless, cloud, fillParticles, live](Bench& b)
+                            {
+                                SDL_Renderer* renderer = headless.state.renderer;
+                                const SDL_FRect viewport{
+                                        0, 0, static_cast<float>(headless.state.logW),
+                                        static_cast<float>(headless.state.logH)
+                                };
+                                ParticleSystem particles;
+                                fillParticles(particles, live);
+                                while (b.next())
+                                {
+                                    SDL_RenderClear(renderer);
+                                    particles.update(FRAME_TIME);
+                                    particles.draw(renderer, {&cloud, 1}, viewport);
+                                    SDL_RenderPresent(renderer);
+                                }
+                                b.setItems(particles.getStats().particles);
+                                b.counter("draw_calls", particles.getStats().drawCalls);
+                            }
+                    });
+        }
+
+        // everything SDL_AppIterate does but the overlay, into the offscreen surface
+        for (const int enemies: {0, 100})
+        {
+            cases.push_back(
+                    {
+                            std::format("frame/software/enemies:{}", enemies),
+                            [&headless, &res, enemies](Bench& b)
+                            {
+                                SDLState& state = headless.state;
+                                GameState gs = newGame(headless, res);
+                                spawnEnemies(gs, res, enemies);
+                                while (b.next())
+                                {
+                                    state.frameArena.reset();
+                                    updateViewport(&gs, &res);
+                                    updateGame(&state, &gs, &res, FRAME_TIME);
+                                    gs.particles.update(FRAME_TIME);
+                                    gs.particles.process(res.emitters, gs.particleEvents);
+                                    drawGame(&state, &gs, &res, FRAME_TIME);
+                                    SDL_RenderPresent(state.renderer);
+                                    res.audio.process(gs.soundEvents, gs.mapViewport);
+                                }
+                                if (queuesGrew(gs))
+                                {
+                                    b.skip("An event queue outgrew GameState's reserve");
+                                    return;
+                                }
+                                b.counter("sprites", state.batchStats.sprites);
+                                b.counter("draw_calls", state.batchStats.drawCalls);
+                                b.counter("sounds_started", res.audio.getStats().started);
+                            }
+                    });
+        }
+
+        // the same frame drawn through the resolution scaler held at a scale, 2.5 fills the
+        // 1600x900 target like drawing straight to it does
+        for (const float scale: {0.5f, 1.0f, 2.5f})
+        {
+            cases.push_back(
+                    {
+                            std::format("frame/software/scale:{}", scale),
+                            [&headless, &res, scale](Bench& b)
+                            {
+                                SDLState& state = headless.state;
+                                state.resolution.init(
+                                        state.renderer, state.logW, state.logH, scale, scale,
+                                        1000);
+                                GameState gs = newGame(headless, res);
+                                spawnEnemies(gs, res, 100);
+                                while (b.next())
+                                {
+                                    state.frameArena.reset();
+                                    updateViewport(&gs, &res);
+                                    updateGame(&state, &gs, &res, FRAME_TIME);
+                                    gs.particles.update(FRAME_TIME);
+                                    gs.particles.process(res.emitters, gs.particleEvents);
+                                    state.resolution.begin();
+                                    drawGame(&state, &gs, &res, FRAME_TIME);
+                                    state.resolution.end();
+                                    SDL_RenderPresent(state.renderer);
+                                    gs.soundEvents.clear();
+                                }
+                                const ResolutionScaler::Stats& stats =
+                                        state.resolution.getStats();
+                                b.counter("pixels", stats.width * stats.height);
+                                b.counter("draw_ms", stats.drawMs);
+                            }
+                    });
+        }
+
+        // the game's whole audio set, as Resources::load() loads it, all of it under one
+        // policy. The time is the loading alone, resident_mb what the process holds more once
+        // it is loaded, which for streamed sounds is only what opening them keeps.
+        const std::vector<std::string> audioFiles = {
+                "data/audio/Juhani Junkala [Retro Game Music Pack] Level 1.mp3",
+                "data/audio/enemy_hit.wav",
+                "data/audio/monster_die.wav",
+                "data/audio/shoot.wav",
+        };
+        for (const LoadPolicy policy: {LoadPolicy::predecoded, LoadPolicy::streamed})
+        {
+            cases.push_back(
+                    {
+                            std::format(
+                                    "audio/load/policy:{}",
+                                    policy == LoadPolicy::predecoded ? "predecoded" : "streamed"),
+                            [&headless, audioFiles, policy](Bench& b)
+                            {
+                                std::unique_ptr<AudioSystem> audio;
+                                size_t before = 0;
+                                while (b.next())
+                                {
+                                    b.pause();
+                                    audio.reset();
+                                    audio = std::make_unique<AudioSystem>();
+                                    audio->init(headless.state.mixer, 16, 8);
+                                    before = currentRss();
+                                    b.resume();
+                                    try
+                                    {
+                                        for (const std::string& file: audioFiles)
+                                        {
+                                            audio->load(file, policy, 1, 0);
+                                        }
+                                    }
+                                    catch (const std::runtime_error&)
+                                    {
+                                        b.skip(std::string("Failed to load audio: ") +
+                                               SDL_GetError());
+                                        return;
+                                    }
+                                }
+                                const size_t after = currentRss();
+                                b.setItems(static_cast<int64_t>(audioFiles.size()));
+                                b.counter(
+                                        "resident_mb",
+                                        after > before ? (after - before) / (1024.0 * 1024.0) : 0);
+                            }
+                    });
+        }
+
+        // a mass kill: count enemies dying in one frame, spread over three viewports around
+        // the visible one, so some are culled and the budget takes the rest
+        for (const int sounds: {10, 500})
+        {
+            cases.push_back(
+                    {
+                            std::format("audio/process/sounds:{}", sounds),
+                            [&headless, &res, sounds](Bench& b)
+                            {
+                                GameState gs = newGame(headless, res);
+                                const SDL_FRect& view = gs.mapViewport;
+                                const int width = static_cast<int>(view.w);
+                                while (b.next())
+                                {
+                                    for (int i = 0; i < sounds; ++i)
+                                    {
+                                        const float x = view.x - view.w +
+                                                        static_cast<float>(i * 37 % 3) * view.w +
+                                                        static_cast<float>(i * 17 % width);
+                                        gs.soundEvents.push_back(
+                                                {res.enemy_die, {x, view.y + view.h / 2}});
+                                    }
+                                    res.audio.process(gs.soundEvents, view);
+                                }
+                                const AudioSystem::Stats& stats = res.audio.getStats();
+                                b.setItems(sounds);
+                                b.counter("culled", stats.culled);
+                                b.counter("over_budget", stats.overBudget);
+                                b.counter("started", stats.started);
+                                b.counter("mixer_ms", stats.mixerMs);
+                            }
+                    });
+        }
+
+        // the visible tiles drawn from textures made the old way, RGBA32 as decoded and blended
+        // with straight alpha, then premultiplied in the renderer's format, then with the opaque
+        // tiles drawn without blending. One texture per tile image in all three, so only the
+        // blits differ.
+        for (const std::string_view upload: {"rgba32", "native", "native+opaque"})
+        {
+            cases.push_back(
+                    {
+                            std::format("tiles/frame/software/textures:{}", upload),
+                            [&headless, &res, upload](Bench& b)
+                            {
+                                SDLState& state = headless.state;
+                                struct TileTexture
+                                {
+                                    AutoRelease<SDL_Texture*> texture;
+                                    bool opaque;
+                                };
+                                std::unordered_map<const AtlasRegion*, TileTexture> tileTextures;
+                                for (size_t t = 0; t < res.map->tileSets.size(); ++t)
+                                {
+                                    const tmx::TileSet& tileSet = res.map->tileSets[t];
+                                    const TileSetTextures& regions = res.tileSetTextures[t];
+                                    for (size_t i = 0; i < tileSet.tiles.size(); ++i)
+                                    {
+                                        const std::string path =
+                                                "data/tiles/" + std::filesystem::path(
+                                                        tileSet.tiles[i].image.source)
+                                                .filename().string();
+                                        AutoRelease<SDL_Surface*> image = {
+                                                IMG_Load_IO(assets::open(path), true),
+                                                SDL_DestroySurface
+                                        };
+                                        if (image == nullptr)
+                                        {
+                                            throw std::runtime_error("Failed to load " + path);
+                                        }
+                                        TileTexture tile{.opaque = upload == "native+opaque"};
+                                        if (upload == "rgba32")
+                                        {
+                                            AutoRelease<SDL_Surface*> rgba = {
+                                                    SDL_ConvertSurface(
+                                                            image, SDL_PIXELFORMAT_RGBA32),
+                                                    SDL_DestroySurface
+                                            };
+                                            tile.texture = {
+                                                    SDL_CreateTextureFromSurface(
+                                                            state.renderer, rgba),
+                                                    SDL_DestroyTexture
+                                            };
+                                        }
+                                        else
+                                        {
+                                            tile.texture = textures::create(state.renderer, image);
+                                            tile.opaque = tile.opaque && textures::isOpaque(image);
+                                        }
+                                        tileTextures.insert_or_assign(
+                                                regions.textures[i], std::move(tile));
+                                    }
+                                }
+
+                                GameState gs = newGame(headless, res);
+                                const float w = static_cast<float>(res.map->tileWidth);
+                                const float h = static_cast<float>(res.map->tileHeight);
+                                while (b.next())
+                                {
+                                    state.frameArena.reset();
+                                    SDL_RenderClear(state.renderer);
+                                    SpriteBatch batch(
+                                            state.frameArena.resource(), state.batchStats.sprites);
+                                    for (int l = 0; l < static_cast<int>(gs.layers.size()); ++l)
+                                    {
+                                        for (const GameObject& obj: gs.layers[l])
+                                        {
+                                            const auto itr = tileTextures.find(obj.texture);
+                                            const SDL_FRect dst{
+                                                    obj.position.x - gs.mapViewport.x,
+                                                    obj.position.y - gs.mapViewport.y, w, h
+                                            };
+                                            if (itr == tileTextures.end() || dst.x + w < 0 ||
+                                                dst.x > state.logW || dst.y + h < 0 ||
+                                                dst.y > state.logH)
+                                            {
+                                                continue;
+                                            }
+                                            batch.draw(
+                                                    itr->second.texture, {0, 0, w, h}, dst,
+                                                    SDL_FLIP_NONE, {1.0f, 1.0f, 1.0f, 1.0f}, l,
+                                                    itr->second.opaque);
+                                        }
+                                    }
+                                    batch.flush(state.renderer);
+                                    state.batchStats = batch.getStats();
+                                    SDL_RenderPresent(state.renderer);
+                                }
+                                b.counter("sprites", state.batchStats.sprites);
+                                b.counter("opaque", state.batchStats.opaque);
+                                b.counter("draw_calls", state.batchStats.drawCalls);
+                            }
+                    });
+        }
+
+        return cases;
+    }
+
+    std::string escape(const std::string_view text)
+    {
+        std::string out;
+        for (const char c: text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out;
+    }
+
+    void writeJson(
+            std::FILE* file, const char* executable, const std::string& mapPath,
+            const std::vector<Result>& results)
+    {
+        std::println(file, "{{");
+        std::println(file, "  \"context\": {{");
+        std::println(
+                file, "    \"date\": \"{:%F %T}\",",
+                std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()));
+        std::println(file, "    \"executable\": \"{}\",", escape(executable));
+        std::println(file, "    \"map\": \"{}\",", escape(mapPath));
+        std::println(file, "    \"num_cpus\": {},", SDL_GetNumLogicalCPUCores());
+#ifdef NDEBUG
+        std::println(file, "    \"library_build_type\": \"release\"");
+#else
+        std::println(file, "    \"library_build_type\": \"debug\"");
+#endif
+        std::println(file, "  }},");
+        std::println(file, "  \"benchmarks\": [");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& r = results[i];
+            std::print(
+                    file, "    {{\"name\": \"{}\", \"run_name\": \"{}\"", r.name, r.name);
+            std::print(file, ", \"run_type\": \"iteration\"");
+            if (!r.error.empty())
+            {
+                std::print(
+                        file, ", \"error_occurred\": true, \"error_message\": \"{}\"",
+                        escape(r.error));
+            }
+            else
+            {
+                std::print(
+                        file, ", \"iterations\": {}, \"real_time\": {:.1f}, \"cpu_time\": {:.1f}"
+                        ", \"time_unit\": \"ns\"", r.iterations, r.realNs, r.cpuNs);
+                for (const auto& [name, value]: r.counters)
+                {
+                    std::print(file, ", \"{}\": {:.3f}", name, value);
+                }
+            }
+            std::println(file, "}}{}", i + 1 < results.size() ? "," : "");
+        }
+        std::println(file, "  ]");
+        std::println(file, "}}");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter, outPath, mapPath = ORIGINAL_MAP, extraMap;
+    double minTime = 0.5;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--filter="))
+        {
+            filter = arg.substr(std::string_view("--filter=").size());
+        }
+        else if (arg.starts_with("--min-time="))
+        {
+            minTime = SDL_atof(argv[i] + std::string_view("--min-time=").size());
+        }
+        else if (arg.starts_with("--out="))
+        {
+            outPath = arg.substr(std::string_view("--out=").size());
+        }
+        else if (arg.starts_with("--map="))
+        {
+            mapPath = arg.substr(std::string_view("--map=").size());
+        }
+        else if (arg.starts_with("--load-map="))
+        {
+            extraMap = arg.substr(std::string_view("--load-map=").size());
+        }
+        else
+        {
+            std::println(
+                    stderr, "usage: {} [--filter=<text>] [--min-time=<seconds>] [--out=<file>] "
+                    "[--map=<file>] [--load-map=<file>]", argv[0]);
+            return 1;
+        }
+    }
+
+    Headless headless;
+    if (!headless.init())
+    {
+        SDL_Log("Headless init failed: %s", SDL_GetError());
+        return 1;
+    }
+    Resources res;
+    try
+    {
+        res.load(&headless.state, mapPath);
+    }
+    catch (const std::runtime_error& e)
+    {
+        SDL_Log("%s", e.what());
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for (const Case& c: makeCases(headless, res, extraMap))
+    {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        Bench bench(minTime);
+        resetPeakRss();
+        c.run(bench);
+        if (const size_t peak = peakRss(); peak > 0)
+        {
+            bench.counter("peak_rss_mb", peak / (1024.0 * 1024.0));
+        }
+        results.push_back(bench.result(c.name));
+
+        const Result& r = results.back();
+        if (r.error.empty())
+        {
+            SDL_Log("%-40s %14.0f ns %10lld", r.name.c_str(), r.realNs,
+                    static_cast<long long>(r.iterations));
+        }
+        else
+        {
+            SDL_Log("%-40s %s", r.name.c_str(), r.error.c_str());
+        }
+    }
+
+    std::FILE* out = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "w");
+    if (out == nullptr)
+    {
+        SDL_Log("Failed to open %s", outPath.c_str());
+        return 1;
+    }
+    writeJson(out, argv[0], mapPath, results);
+    if (out != stdout)
+    {
+        std::fclose(out);
+    }
+    return 0;
+}
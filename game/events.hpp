@@ -0,0 +1,52 @@
+#pragma once
+#include <variant>
+#include <glm/glm.hpp>
+
+#include "registry.hpp"
+
+// What shooting and collisions did during a tick, queued in GameState::events and acted on
+// once everything has moved. A collision response only changes the object that is moving,
+// what it ran into reacts to the event afterwards, and so do the sounds and particles.
+namespace events
+{
+    // a bullet left the gun at position
+    struct Fired
+    {
+        glm::vec2 position{};
+        float direction{};
+    };
+
+    // a bullet stopped against the level
+    struct HitWall
+    {
+        glm::vec2 position{};
+        float direction{}; // of the bullet
+    };
+
+    // a bullet hit an enemy that was still alive when it touched it. Its health points and
+    // state were taken at once, so the next bullet in the tick flies through if it died.
+    struct Hit
+    {
+        ObjectHandle enemy{};
+        glm::vec2 position{};
+        float direction{}; // of the bullet
+        bool fatal{};      // a Killed follows
+    };
+
+    // the hit took the enemy's last health points
+    struct Killed
+    {
+        ObjectHandle enemy{};
+        float direction{}; // of the bullet
+    };
+
+    // an enemy shoved a player away
+    struct Pushed
+    {
+        ObjectHandle target{};
+        glm::vec2 velocity{};
+    };
+}
+
+using GameplayEvent = std::variant<
+        events::Fired, events::HitWall, events::Hit, events::Killed, events::Pushed>;
@@ -0,0 +1,177 @@
+#include "flowfield.hpp"
+
+FlowField::FlowField(
+        const int width, const int height, const int tileWidth, const int tileHeight,
+        const std::vector<int>& level, const int maxDistance)
+    : width(width), height(height), tileWidth(tileWidth), tileHeight(tileHeight),
+      maxDistance(maxDistance), cells(width * height), distances(width * height, UNREACHED)
+{
+    for (int i = 0; i < width * height; ++i)
+    {
+        cells[i] = level[i] ? SOLID : 0;
+    }
+    for (int r = 0; r < height; ++r)
+    {
+        for (int c = 0; c < width; ++c)
+        {
+            if (!isSolid(c, r) && isSolid(c, r + 1))
+            {
+                cells[r * width + c] |= STANDABLE;
+            }
+        }
+    }
+}
+
+glm::ivec2 FlowField::cellAt(const glm::vec2 point) const
+{
+    return {
+            static_cast<int>(glm::floor(point.x / tileWidth)),
+            static_cast<int>(glm::floor(point.y / tileHeight))
+    };
+}
+
+bool FlowField::setTarget(const glm::ivec2 cell)
+{
+    const int newTarget = landing(cell.x, cell.y);
+    if (newTarget == target)
+    {
+        return false;
+    }
+    target = newTarget;
+    recompute();
+    return true;
+}
+
+FlowField::Step FlowField::step(const glm::ivec2 cell) const
+{
+    Step result;
+    const int from = landing(cell.x, cell.y);
+    if (from < 0 || distances[from] == UNREACHED)
+    {
+        return result;
+    }
+    result.distance = distances[from];
+
+    // pick the neighbour closest to the target
+    const int c = from % width;
+    const int r = from / width;
+    int best = result.distance;
+    for (const int dc: {-1, 1})
+    {
+        if (!isSolid(c + dc, r))
+        {
+            // walk, or fall down to whatever is below the next column
+            const int next = landing(c + dc, r);
+            if (next >= 0 && distances[next] < best)
+            {
+                best = distances[next];
+                result.dx = dc;
+                result.jump = false;
+            }
+        }
+        else if (!isSolid(c, r - 1) && isStandable(c + dc, r - 1))
+        {
+            // jump one tile up onto the step
+            const int next = (r - 1) * width + c + dc;
+            if (distances[next] < best)
+            {
+                best = distances[next];
+                result.dx = dc;
+                result.jump = true;
+            }
+        }
+    }
+    return result;
+}
+
+bool FlowField::isSolid(const int c, const int r) const
+{
+    // everything outside the map is a wall
+    if (c < 0 || c >= width || r < 0 || r >= height)
+    {
+        return true;
+    }
+    return cells[r * width + c] & SOLID;
+}
+
+bool FlowField::isStandable(const int c, const int r) const
+{
+    if (c < 0 || c >= width || r < 0 || r >= height)
+    {
+        return false;
+    }
+    return cells[r * width + c] & STANDABLE;
+}
+
+int FlowField::landing(const int c, int r) const
+{
+    for (; !isSolid(c, r); ++r)
+    {
+        if (isStandable(c, r))
+        {
+            return r * width + c;
+        }
+    }
+    return -1;
+}
+
+void FlowField::recompute()
+{
+    // only reset what the previous search touched, so the cost is bounded by maxDistance
+    for (const int i: visited)
+    {
+        distances[i] = UNREACHED;
+    }
+    visited.clear();
+    if (target < 0)
+    {
+        return;
+    }
+
+    // breadth-first search backwards from the target over the moves an enemy can make
+    distances[target] = 0;
+    visited.push_back(target);
+    for (size_t head = 0; head < visited.size(); ++head)
+    {
+        const int v = visited[head];
+        const uint16_t d = distances[v];
+        if (d >= maxDistance)
+        {
+            continue;
+        }
+        const int c = v % width;
+        const int r = v / width;
+
+        const auto reach = [&](const int pc, const int pr)
+        {
+            if (!isStandable(pc, pr))
+            {
+                return;
+            }
+            const int i = pr * width + pc;
+            if (distances[i] == UNREACHED)
+            {
+                distances[i] = d + 1;
+                visited.push_back(i);
+            }
+        };
+
+        for (const int dc: {-1, 1})
+        {
+            // walk along the same row
+            reach(c + dc, r);
+            // walk off a ledge above and fall down onto v, a fall counts as one step but
+            // only from as many tiles up as the search goes sideways, so a tall open
+            // column costs no more than a short one
+            for (int pr = r - 1; pr >= r - maxDistance && !isSolid(c, pr); --pr)
+            {
+                reach(c + dc, pr);
+            }
+            // jump up one tile onto v
+            if (!isSolid(c + dc, r))
+            {
+                reach(c + dc, r + 1);
+            }
+        }
+    }
+}
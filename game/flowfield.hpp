@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Distance map toward one target over the tile cells an enemy can stand on.
+// It is recomputed only when the target changes cell and is bounded by maxDistance,
+// so every enemy shares it and looks up its next move in constant time.
+class FlowField
+{
+public:
+
+    struct Step
+    {
+        int dx{};          // horizontal direction to move, -1, 0 or 1
+        bool jump{};       // next cell is one tile up
+        int distance = -1; // steps to the target, -1 if unreachable
+    };
+
+    FlowField() = default;
+    FlowField(
+            int width, int height, int tileWidth, int tileHeight, const std::vector<int>& level,
+            int maxDistance);
+
+    [[nodiscard]] glm::ivec2 cellAt(glm::vec2 point) const;
+    // returns true if the field had to be recomputed
+    bool setTarget(glm::ivec2 cell);
+    [[nodiscard]] Step step(glm::ivec2 cell) const;
+
+private:
+
+    static constexpr uint8_t SOLID = 1;
+    static constexpr uint8_t STANDABLE = 2; // empty with a solid cell below
+    static constexpr uint16_t UNREACHED = 0xFFFF;
+
+    int width{}, height{};
+    int tileWidth{}, tileHeight{};
+    int maxDistance{};
+    std::vector<uint8_t> cells{};
+    std::vector<uint16_t> distances{};
+    // cells written by the last recompute, also used as the BFS queue
+    std::vector<int> visited{};
+    int target = -1;
+
+    [[nodiscard]] bool isSolid(int c, int r) const;
+    [[nodiscard]] bool isStandable(int c, int r) const;
+    // first standable cell at or below (c, r), -1 if none
+    [[nodiscard]] int landing(int c, int r) const;
+    void recompute();
+};
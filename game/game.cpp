@@ -0,0 +1,1639 @@
+#include "game.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+#include <SDL3_image/SDL_image.h>
+
+#include "pack.hpp"
+#include "textures.hpp"
+
+SDL_Texture* Resources::loadTexture(SDL_Renderer* renderer, const std::string& filepath)
+{
+    AutoRelease<SDL_Surface*> surface = {
+            IMG_Load_IO(assets::open(filepath), true), SDL_DestroySurface
+    };
+    if (surface == nullptr)
+    {
+        throw std::runtime_error("Failed to load " + std::string(filepath));
+    }
+    AutoRelease<SDL_Texture*> tex = textures::create(renderer, surface);
+    SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
+    texturePaths[filepath] = textures.size();
+    textures.push_back(std::move(tex));
+    return textures.back();
+}
+
+void Resources::load(const SDLState* state, const std::string& filepath)
+{
+    playerAnims.resize(5);
+    playerAnims[ANIM_PLAYER_IDLE] = Animation{8, 1.6f};
+    playerAnims[ANIM_PLAYER_RUNNING] = Animation{4, 0.5f};
+    playerAnims[ANIM_PLAYER_SLIDE] = Animation{1, 1.0f};
+    playerAnims[ANIM_PLAYER_SHOOT] = Animation{4, 0.5f};
+    playerAnims[ANIM_PLAYER_SLIDE_SHOOT] = Animation{4, 0.5f};
+
+    bulletAnims.resize(2);
+    bulletAnims[ANIM_BULLET_MOVING] = Animation{4, 0.05f};
+    bulletAnims[ANIM_BULLET_HIT] = Animation{4, 0.15f};
+
+    enemyAnims.resize(3);
+    enemyAnims[ANIM_ENEMY] = Animation{8, 1.0f};
+    enemyAnims[ANIM_ENEMY_HIT] = Animation{8, 1.0f};
+    enemyAnims[ANIM_ENEMY_DIE] = Animation{18, 2.0f};
+
+    texIdle = atlas.add("data/idle.png");
+    texRun = atlas.add("data/run.png");
+    texSlide = atlas.add("data/slide.png");
+    texShoot = atlas.add("data/shoot.png");
+    texRunShoot = atlas.add("data/shoot_run.png");
+    texSlideShoot = atlas.add("data/slide_shoot.png");
+    texBrick = atlas.add("data/tiles/brick.png");
+    texGrass = atlas.add("data/tiles/grass.png");
+    texGround = atlas.add("data/tiles/ground.png");
+    texPanel = atlas.add("data/tiles/panel.png");
+    // backgrounds are tiled across the screen, they keep their own textures
+    texBg1 = loadTexture(state->renderer, "data/bg/bg_layer1.png");
+    texBg2 = loadTexture(state->renderer, "data/bg/bg_layer2.png");
+    texBg3 = loadTexture(state->renderer, "data/bg/bg_layer3.png");
+    texBg4 = loadTexture(state->renderer, "data/bg/bg_layer4.png");
+    texBullet = atlas.add("data/bullet.png");
+    texBulletHit = atlas.add("data/bullet_hit.png");
+    texEnemy = atlas.add("data/enemy.png");
+    texEnemyHit = atlas.add("data/enemy_hit.png");
+    texEnemyDie = atlas.add("data/enemy_die.png");
+
+    audio.init(state->mixer, 16, 8);
+    // long music is streamed from disk, short effects are decoded up front
+    music = audio.load(
+            "data/audio/Juhani Junkala [Retro Game Music Pack] Level 1.mp3",
+            LoadPolicy::streamed, 1, 0);
+    // maxVoices, priority: deaths are rarer and matter more than hits and shots
+    enemy_hit = audio.load("data/audio/enemy_hit.wav", LoadPolicy::predecoded, 4, 1);
+    enemy_die = audio.load("data/audio/monster_die.wav", LoadPolicy::predecoded, 4, 2);
+    shoot = audio.load("data/audio/shoot.wav", LoadPolicy::predecoded, 3, 0);
+    audio.logLoadStats();
+
+    // effects are flat coloured squares, angles are radians with 0 pointing forward
+    const auto addEmitter = [this](const ParticleEmitter& emitter)
+    {
+        emitters.push_back(emitter);
+        return emitters.size() - 1;
+    };
+    sparks = addEmitter(
+            {
+                    .count = 8, .spread = 0.8f, .speedMin = 60, .speedMax = 160,
+                    .lifetimeMin = 0.15f, .lifetimeMax = 0.35f, .gravity = 400, .sizeStart = 2,
+                    .sizeEnd = 1, .colorStart = {1.0f, 0.9f, 0.5f, 1.0f},
+                    .colorEnd = {1.0f, 0.4f, 0.1f, 0.0f}
+            });
+    enemy_blood = addEmitter(
+            {
+                    .count = 12, .angle = 0.3f, .spread = 0.7f, .speedMin = 40, .speedMax = 120,
+                    .lifetimeMin = 0.3f, .lifetimeMax = 0.6f, .gravity = 500, .sizeStart = 2,
+                    .sizeEnd = 2, .colorStart = {0.5f, 0.8f, 0.2f, 1.0f},
+                    .colorEnd = {0.3f, 0.5f, 0.1f, 0.0f}
+            });
+    enemy_gibs = addEmitter(
+            {
+                    .count = 40, .angle = SDL_PI_F / 2, .spread = SDL_PI_F, .speedMin = 60,
+                    .speedMax = 200, .lifetimeMin = 0.5f, .lifetimeMax = 1.0f, .gravity = 500,
+                    .sizeStart = 3, .sizeEnd = 1, .colorStart = {0.6f, 0.9f, 0.3f, 1.0f},
+                    .colorEnd = {0.2f, 0.4f, 0.1f, 0.0f}
+            });
+    muzzle_flash = addEmitter(
+            {
+                    .count = 6, .spread = 0.35f, .speedMin = 80, .speedMax = 200,
+                    .lifetimeMin = 0.05f, .lifetimeMax = 0.12f, .sizeStart = 3, .sizeEnd = 1,
+                    .colorStart = {1.0f, 1.0f, 0.8f, 1.0f}, .colorEnd = {1.0f, 0.6f, 0.2f, 0.0f}
+            });
+
+    // the same form the file watcher reports paths in
+    mapPath = std::filesystem::path(filepath).lexically_normal().generic_string();
+    map = tmx::loadMap(mapPath, tileSetCache);
+    if (!map)
+    {
+        throw std::runtime_error("Error loading map.");
+    }
+    loadTileSets();
+    loadParallaxLayers(state->renderer);
+
+    // all sheets are known, pack them
+    atlas.build(state->renderer);
+    tileAnimations.update(0);
+}
+
+void Resources::loadTileSets()
+{
+    tileSetTextures.clear();
+    for (const tmx::TileSet& tileSet: map->tileSets)
+    {
+        TileSetTextures tst;
+        tst.firstgid = tileSet.firstgid;
+        tst.textures.reserve(tileSet.tiles.size());
+
+        for (const tmx::Tile& tile: tileSet.tiles)
+        {
+            const std::string imagePath =
+                    "data/tiles/" + std::filesystem::path(tile.image.source).filename().string();
+            tst.textures.push_back(atlas.add(imagePath));
+        }
+
+        tileSetTextures.push_back(std::move(tst));
+    }
+    tileAnimations.load(map->tileSets, tileSetTextures);
+}
+
+void Resources::loadParallaxLayers(SDL_Renderer* renderer)
+{
+    // built aside, an image that fails to load leaves the layers in use as they are
+    std::vector<ParallaxLayer> layers;
+    const std::filesystem::path mapDir = std::filesystem::path(mapPath).parent_path();
+    for (const tmx::ImageLayer& imageLayer: map->imageLayers)
+    {
+        if (imageLayer.image.source.empty())
+        {
+            continue;
+        }
+        // keyed like every other texture, so a reload of the map or of the image finds it
+        const std::string path =
+                (mapDir / imageLayer.image.source).lexically_normal().generic_string();
+        const auto itr = texturePaths.find(path);
+        SDL_Texture* texture = itr != texturePaths.end() ? textures[itr->second]
+                                                         : loadTexture(renderer, path);
+        layers.push_back(
+                {.texture = texture, .scrollFactor = imageLayer.parallaxX,
+                 .y = imageLayer.offsetY});
+    }
+    // maps without image layers get the backgrounds the game always had
+    if (layers.empty())
+    {
+        layers = {
+                {.texture = texBg4, .scrollFactor = 0.075f, .y = 30},
+                {.texture = texBg3, .scrollFactor = 0.150f, .y = 30},
+                {.texture = texBg2, .scrollFactor = 0.3f, .y = 30},
+        };
+    }
+    parallaxLayers = std::move(layers);
+}
+
+bool Resources::reloadTexture(SDL_Renderer* renderer, const std::string& filepath)
+{
+    if (atlas.reload(renderer, filepath))
+    {
+        return true;
+    }
+    const auto itr = texturePaths.find(filepath);
+    if (itr == texturePaths.end())
+    {
+        return false;
+    }
+
+    AutoRelease<SDL_Surface*> surface = {
+            IMG_Load_IO(assets::open(filepath), true), SDL_DestroySurface
+    };
+    if (surface == nullptr)
+    {
+        throw std::runtime_error("Failed to load " + filepath);
+    }
+    SDL_Texture* oldTex = textures[itr->second];
+    const SDL_Surface* image = surface;
+    SDL_BlendMode oldBlendMode = SDL_BLENDMODE_BLEND;
+    SDL_GetTextureBlendMode(oldTex, &oldBlendMode);
+    // an image that gained or lost transparency needs a texture with another format
+    if (image->w == oldTex->w && image->h == oldTex->h &&
+        textures::isOpaque(surface) == (oldBlendMode == SDL_BLENDMODE_NONE))
+    {
+        // same size, update the pixels so every pointer to the texture stays valid
+        AutoRelease<SDL_Surface*> converted = textures::convertFor(oldTex, surface);
+        const SDL_Surface* pixels = converted;
+        SDL_UpdateTexture(oldTex, nullptr, pixels->pixels, pixels->pitch);
+        return true;
+    }
+
+    AutoRelease<SDL_Texture*> tex = textures::create(renderer, surface);
+    SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
+    SDL_Texture* newTex = tex;
+    for (SDL_Texture** bg: {&texBg1, &texBg2, &texBg3, &texBg4})
+    {
+        if (*bg == oldTex)
+        {
+            *bg = newTex;
+        }
+    }
+    for (ParallaxLayer& layer: parallaxLayers)
+    {
+        if (layer.texture == oldTex)
+        {
+            layer.texture = newTex;
+        }
+    }
+    textures[itr->second] = std::move(tex);
+    return true;
+}
+
+void drawObject(
+        const SDLState* state, const GameState* gs, SpriteBatch& batch, GameObject& obj,
+        const int layer, const float width, const float height, const float deltaTime)
+{
+    // check if flash timer has finished, even if the object is off screen
+    if (obj.shouldFlash && obj.flashTimer.step(deltaTime))
+    {
+        obj.shouldFlash = false;
+    }
+
+    const SDL_FRect dst{
+            .x = obj.position.x - gs->mapViewport.x, .y = obj.position.y - gs->mapViewport.y,
+            .w = width, .h = height
+    };
+    if (dst.x + dst.w < 0 || dst.x > state->logW || dst.y + dst.h < 0 || dst.y > state->logH)
+    {
+        return;
+    }
+
+    // frames are laid out horizontally in the sheet, which sits somewhere in an atlas page
+    SDL_FRect src{.x = obj.texture->rect.x, .y = obj.texture->rect.y, .w = width, .h = height};
+
+    // if currentAnimation == -1, draw the specific frame index spriteFrame
+    src.x += obj.currentAnimation >= 0
+                 ? obj.animations[obj.currentAnimation].currentFrame() * width
+                 : (obj.spriteFrame - 1) * width;
+
+    const SDL_FlipMode flipMode = obj.direction < 0 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+
+    // flash object with a red-ish tint
+    const SDL_FColor color = obj.shouldFlash
+                                 ? SDL_FColor{2.5f, 1.0f, 1.0f, 1.0f}
+                                 : SDL_FColor{1.0f, 1.0f, 1.0f, 1.0f};
+
+    // opaque sheets, the tiles mostly, overwrite what is below them instead of blending
+    batch.draw(obj.texture->texture, src, dst, flipMode, color, layer, obj.texture->opaque);
+}
+
+void drawDebug(const SDLState* state, const GameState* gs, const GameObject& obj)
+{
+    SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_BLEND);
+
+    // collision
+    const SDL_FRect rectA = {
+            obj.position.x + obj.collider.x - gs->mapViewport.x,
+            obj.position.y + obj.collider.y - gs->mapViewport.y,
+            obj.collider.w,
+            obj.collider.h,
+    };
+    SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 150);
+    SDL_RenderFillRect(state->renderer, &rectA);
+
+    // ground sensor
+    const SDL_FRect ground_sensor{
+            .x = obj.position.x + obj.collider.x - gs->mapViewport.x,
+            .y = obj.position.y + obj.collider.y + obj.collider.h - gs->mapViewport.y,
+            .w = obj.collider.w, .h = 1
+    };
+    SDL_SetRenderDrawColor(state->renderer, 0, 0, 255, 150);
+    SDL_RenderFillRect(state->renderer, &ground_sensor);
+
+    SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_NONE);
+}
+
+namespace
+{
+    // what a player does this tick, returns the direction it pushes in
+    float updateBehaviour(
+            const SDLState*, GameState* gs, const Resources* res, GameObject& obj, PlayerData& d,
+            const float deltaTime)
+    {
+        float currentDirection = 0;
+        const PlayerInput input = gs->inputs[d.id];
+        if (input.held(PlayerInput::left))
+        {
+            currentDirection += -1;
+        }
+        if (input.held(PlayerInput::right))
+        {
+            currentDirection += 1;
+        }
+
+        const auto handleJump = [&]()
+        {
+            if (input.held(PlayerInput::jump) && obj.grounded)
+            {
+                constexpr float JUMP_FORCE = -200.0f;
+                obj.velocity.y += JUMP_FORCE;
+                d.state = PlayerState::jumping;
+                obj.grounded = false;
+            }
+        };
+
+        Timer& weaponTimer = d.weaponTimer;
+        weaponTimer.step(deltaTime);
+        const auto handleShooting = [&](
+                const AtlasRegion* tex, const AtlasRegion* shootTex, const int animIndex,
+                const int shootAnimIndex)
+        {
+            if (input.held(PlayerInput::shoot))
+            {
+                // set shooting tex/anim
+                obj.texture = shootTex;
+                obj.currentAnimation = shootAnimIndex;
+
+                if (weaponTimer.isTimeout())
+                {
+                    weaponTimer.reset();
+                    fireBullet(gs, res, obj);
+                }
+            }
+            else
+            {
+                obj.texture = tex;
+                obj.currentAnimation = animIndex;
+            }
+        };
+
+        switch (d.state)
+        {
+            case PlayerState::idle:
+            {
+                if (currentDirection != 0)
+                {
+                    d.state = PlayerState::running;
+                }
+                else
+                {
+                    // deacceleration
+                    if (obj.velocity.x != 0)
+                    {
+                        const float factor = obj.velocity.x > 0 ? -1.5f : 1.5f;
+                        const float amount = factor * obj.acceleration.x * deltaTime;
+                        if (std::abs(obj.velocity.x) < std::abs(amount))
+                        {
+                            obj.velocity.x = 0;
+                        }
+                        else
+                        {
+                            obj.velocity.x += amount;
+                        }
+                    }
+                }
+                handleJump();
+                handleShooting(
+                        res->texIdle, res->texShoot, res->ANIM_PLAYER_IDLE, res->ANIM_PLAYER_SHOOT);
+                break;
+            }
+            case PlayerState::running:
+            {
+                if (currentDirection == 0)
+                {
+                    d.state = PlayerState::idle;
+                }
+                handleJump();
+
+                // moving in opposite direction of velocity, sliding! (changing direction during move)
+                if (obj.velocity.x * obj.direction < 0 && obj.grounded)
+                {
+                    handleShooting(
+                            res->texSlide, res->texSlideShoot, res->ANIM_PLAYER_SLIDE,
+                            res->ANIM_PLAYER_SLIDE_SHOOT);
+                }
+                else
+                {
+                    // when running, use same index. Both texture have the same size, so, the Animation class
+                    // can use the same frameIndex when switching images
+                    handleShooting(
+                            res->texRun, res->texRunShoot, res->ANIM_PLAYER_RUNNING,
+                            res->ANIM_PLAYER_RUNNING);
+                }
+                break;
+            }
+            case PlayerState::jumping:
+            {
+                handleShooting(
+                        res->texRun, res->texRunShoot, res->ANIM_PLAYER_RUNNING,
+                        res->ANIM_PLAYER_RUNNING);
+                if (obj.grounded)
+                {
+                    d.state = PlayerState::running;
+                    // if player stopped running, the next frame will change to idle
+                }
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+        return currentDirection;
+    }
+
+    float updateBehaviour(
+            const SDLState* state, GameState* gs, const Resources*, GameObject& obj, BulletData& d,
+            const float)
+    {
+        switch (d.state)
+        {
+            case BulletState::moving:
+            {
+                if (obj.position.x - gs->mapViewport.x < 0 ||
+                    obj.position.x - gs->mapViewport.x > state->logW ||
+                    obj.position.y - gs->mapViewport.y < 0 ||
+                    obj.position.y - gs->mapViewport.y > state->logH
+                )
+                {
+                    d.state = BulletState::inactive;
+                }
+                break;
+            }
+            case BulletState::colliding:
+            {
+                if (obj.animations[obj.currentAnimation].isDone())
+                {
+                    d.state = BulletState::inactive;
+                }
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+        return 0;
+    }
+
+    float updateBehaviour(
+            const SDLState*, GameState* gs, const Resources* res, GameObject& obj, EnemyData& d,
+            const float deltaTime)
+    {
+        float currentDirection = 0;
+        switch (d.state)
+        {
+            case EnemyState::shambling:
+            {
+                const SDL_FRect rect = obj.GetCollider();
+                const glm::ivec2 cell = gs->flowField.cellAt(
+                        {rect.x + rect.w / 2, rect.y + rect.h - 1});
+                const FlowField::Step step = gs->flowField.step(cell);
+                if (step.distance >= 0)
+                {
+                    if (step.dx != 0)
+                    {
+                        currentDirection = step.dx;
+                    }
+                    else // same cell as the player
+                    {
+                        currentDirection = gs->player().position.x > obj.position.x ? 1 : -1;
+                    }
+                    obj.acceleration = glm::vec2(30, 0);
+
+                    // jump onto a tile step once we are pushing against it
+                    const float front = step.dx > 0 ? rect.x + rect.w : rect.x;
+                    const float edge = (cell.x + (step.dx > 0 ? 1 : 0)) * res->map->tileWidth;
+                    if (step.jump && obj.grounded && std::abs(front - edge) < 1.0f)
+                    {
+                        constexpr float JUMP_FORCE = -200.0f;
+                        obj.velocity.y += JUMP_FORCE;
+                        obj.grounded = false;
+                    }
+                }
+                else
+                {
+                    obj.acceleration = glm::vec2{0};
+                    obj.velocity.x = 0;
+                }
+                break;
+            }
+            case EnemyState::damaged:
+            {
+                // if damaged timer has finished, go back to shambling
+                if (d.damagedTimer.step(deltaTime))
+                {
+                    d.state = EnemyState::shambling;
+                    obj.texture = res->texEnemy;
+                    obj.currentAnimation = res->ANIM_ENEMY;
+                }
+                break;
+            }
+            case EnemyState::dead:
+            {
+                obj.velocity.x = 0;
+                // when enemy is dead, make it draw only the last frame
+                if (obj.currentAnimation != -1 &&
+                    obj.animations[obj.currentAnimation].isDone())
+                {
+                    obj.currentAnimation = -1;
+                    obj.spriteFrame = 18;
+                }
+                // then lie there a while before the corpse goes
+                else if (obj.currentAnimation == -1 && d.corpseTimer.step(deltaTime))
+                {
+                    destroyObject(gs, obj.handle);
+                }
+                break;
+            }
+        }
+        return currentDirection;
+    }
+
+    // tiles only move when something pushes them
+    float updateBehaviour(
+            const SDLState*, GameState*, const Resources*, GameObject&, LevelData&, const float)
+    {
+        return 0;
+    }
+
+    // moves a back out of rectB along the axis it was moving on
+    void pushOut(const SDL_FRect& rectB, GameObject& a, const bool isHorizontal, const bool ground)
+    {
+        if (isHorizontal) // horizontal collision
+        {
+            if (a.velocity.x > 0) // going right
+            {
+                a.position.x = rectB.x - a.collider.w - a.collider.x;
+                a.velocity.x = 0;
+            }
+            else if (a.velocity.x < 0)
+            {
+                a.position.x = rectB.x + rectB.w - a.collider.x;
+                a.velocity.x = 0;
+            }
+        }
+        else // vertical
+        {
+            if (a.velocity.y > 0) // going down
+            {
+                a.position.y = rectB.y - a.collider.h - a.collider.y;
+                a.velocity.y = 0;
+                a.grounded = a.grounded || ground;
+            }
+            else if (a.velocity.y < 0)
+            {
+                a.position.y = rectB.y + rectB.h - a.collider.y;
+                a.velocity.y = 0;
+            }
+        }
+    }
+
+    // a moving bullet hitting something stops and plays its hit animation
+    void stopBullet(
+            const Resources* res, const SDL_FRect& rectB, GameObject& a, const bool isHorizontal)
+    {
+        pushOut(rectB, a, isHorizontal, false);
+        a.get<BulletData>().state = BulletState::colliding;
+        a.texture = res->texBulletHit;
+        a.currentAnimation = res->ANIM_BULLET_HIT;
+        // force velocity 0 bullet changes state on vertical and next frame pushOut()
+        // is not called for horizontal because of change state
+        a.velocity *= 0;
+    }
+
+    // what happens to a when it runs into b, b only hears of it through gs->events.
+    // Pairs not listed do nothing.
+    template<ObjectType A, ObjectType B>
+    void respond(
+            const Resources* res, GameState* gs, const SDL_FRect& rectB, GameObject& a,
+            GameObject& b, const bool isHorizontal)
+    {
+        if constexpr (A == ObjectType::player && B == ObjectType::level)
+        {
+            pushOut(rectB, a, isHorizontal, true);
+        }
+        else if constexpr (A == ObjectType::player && B == ObjectType::enemy)
+        {
+            // bounce player if collides with enemy
+            if (b.get<EnemyData>().state != EnemyState::dead)
+            {
+                a.velocity = glm::vec2(100, 0) * -a.direction;
+            }
+        }
+        else if constexpr (A == ObjectType::bullet && B == ObjectType::level)
+        {
+            if (a.get<BulletData>().state != BulletState::moving)
+            {
+                return;
+            }
+            // the bullet's centre, before stopBullet() moves it out of the wall
+            const glm::vec2 hitPosition = a.position +
+                                          glm::vec2(a.collider.w, a.collider.h) / 2.0f;
+            stopBullet(res, rectB, a, isHorizontal);
+            gs->events.push_back(events::HitWall{hitPosition, a.direction});
+        }
+        else if constexpr (A == ObjectType::bullet && B == ObjectType::enemy)
+        {
+            if (a.get<BulletData>().state != BulletState::moving ||
+                b.get<EnemyData>().state == EnemyState::dead)
+            {
+                return;
+            }
+            const glm::vec2 hitPosition = a.position +
+                                          glm::vec2(a.collider.w, a.collider.h) / 2.0f;
+            // the damage is taken now, so later pairs of the tick see a dead enemy as dead;
+            // how it looks and sounds is left to processEvents()
+            EnemyData& d = b.get<EnemyData>();
+            d.state = EnemyState::damaged;
+            d.healthPoints -= 10;
+            if (d.healthPoints <= 0)
+            {
+                d.state = EnemyState::dead;
+            }
+            const bool fatal = d.state == EnemyState::dead;
+            gs->events.push_back(events::Hit{b.handle, hitPosition, a.direction, fatal});
+            if (fatal)
+            {
+                gs->events.push_back(events::Killed{b.handle, a.direction});
+            }
+            stopBullet(res, rectB, a, isHorizontal);
+        }
+        else if constexpr (A == ObjectType::enemy)
+        {
+            pushOut(rectB, a, isHorizontal, B == ObjectType::level);
+            // bounce player if collides with enemy
+            if constexpr (B == ObjectType::player)
+            {
+                if (a.get<EnemyData>().state != EnemyState::dead)
+                {
+                    const int ax = a.position.x + a.collider.x + a.collider.w / 2;
+                    const int bx = b.position.x + b.collider.x + b.collider.w / 2;
+                    gs->events.push_back(
+                            events::Pushed{
+                                    b.handle, glm::vec2(100, 0) * (ax > bx ? -1.0f : 1.0f)
+                            });
+                }
+            }
+        }
+    }
+
+    using Response = void (*)(
+            const Resources* res, GameState* gs, const SDL_FRect& rectB, GameObject& a,
+            GameObject& b, bool isHorizontal);
+
+    template<size_t... Pair>
+    constexpr std::array<Response, sizeof...(Pair)> makeResponses(std::index_sequence<Pair...>)
+    {
+        return {
+                &respond<static_cast<ObjectType>(Pair / OBJECT_TYPE_COUNT),
+                         static_cast<ObjectType>(Pair % OBJECT_TYPE_COUNT)>...
+        };
+    }
+
+    // every (a, b) pair of types, at a * OBJECT_TYPE_COUNT + b
+    constexpr auto RESPONSES = makeResponses(
+            std::make_index_sequence<OBJECT_TYPE_COUNT * OBJECT_TYPE_COUNT>());
+
+    // how a reacts to b, a's row of the table is picked at compile time
+    template<ObjectType A>
+    Response responseTo(const GameObject& b)
+    {
+        return RESPONSES[static_cast<size_t>(A) * OBJECT_TYPE_COUNT +
+                         static_cast<size_t>(b.type())];
+    }
+
+    // rectB is filled in when they overlap
+    bool touching(const GameObject& objA, const GameObject& objB, SDL_FRect& rectB)
+    {
+        const SDL_FRect rectA = objA.GetCollider();
+        rectB = objB.GetCollider();
+        SDL_FRect rectC{}; // collision result
+        return SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC) &&
+               rectC.w > 0.00001f && rectC.h > 0.00001f;
+    }
+
+    template<ObjectType A>
+    void checkCollision(
+            const Resources* res, GameState* gs, GameObject& objA, GameObject& objB,
+            const bool isHorizontal)
+    {
+        ++gs->collisionTests;
+        SDL_FRect rectB;
+        if (touching(objA, objB, rectB))
+        {
+            // anything touching a sleeping object wakes it up
+            if (objB.sleeping)
+            {
+                objB.wake();
+            }
+            responseTo<A>(objB)(res, gs, rectB, objA, objB, isHorizontal);
+        }
+    }
+
+    // the solid tiles within CONTACT_MARGIN of obj, from every layer without dynamic objects
+    void findContacts(GameState* gs, GameObject& obj)
+    {
+        ContactCache& cache = obj.contacts;
+        const SDL_FRect rect = obj.GetCollider();
+        cache.bounds = {
+                rect.x - CONTACT_MARGIN, rect.y - CONTACT_MARGIN, rect.w + 2 * CONTACT_MARGIN,
+                rect.h + 2 * CONTACT_MARGIN
+        };
+        cache.version = gs->layersVersion;
+        cache.tiles.clear();
+        const ObjectIndex& index = gs->objectIndex;
+        for (int l = 0; l < static_cast<int>(gs->layers.size()); ++l)
+        {
+            if (index.dynamicLayers[l] || index.categories[l] == 0)
+            {
+                continue;
+            }
+            const std::vector<GameObject>& layer = gs->layers[l];
+            for (int i = 0; i < static_cast<int>(layer.size()); ++i)
+            {
+                const SDL_FRect collider = layer[i].GetCollider();
+                if (collider.w != 0 && collider.h != 0 &&
+                    SDL_HasRectIntersectionFloat(&cache.bounds, &collider))
+                {
+                    cache.tiles.push_back({l, i});
+                }
+            }
+        }
+        ++gs->contactScans;
+    }
+
+    // obj against everything its collision mask accepts, skipping whole layers of things
+    // it can't touch before any rect is tested. Tile layers only test the tiles in obj's
+    // contact cache, the others can't overlap it while it stays inside the cache's bounds.
+    template<ObjectType T>
+    void collideWithLayers(
+            const Resources* res, GameState* gs, GameObject& obj, const bool isHorizontal)
+    {
+        const ObjectIndex& index = gs->objectIndex;
+        assert(index.categories.size() == gs->layers.size());
+        ContactCache& cache = obj.contacts;
+        if (cache.version != gs->layersVersion || !cache.covers(obj.GetCollider()))
+        {
+            findContacts(gs, obj);
+        }
+        const auto collideWith = [&](GameObject& objB)
+        {
+            if (&obj != &objB && obj.collision.accepts(objB.collision.category) &&
+                objB.collider.w != 0 && objB.collider.h != 0)
+            {
+                checkCollision<T>(res, gs, obj, objB, isHorizontal);
+            }
+        };
+
+        auto tile = cache.tiles.begin();
+        for (int l = 0; l < static_cast<int>(gs->layers.size()); ++l)
+        {
+            // the cached tiles of this layer
+            const auto first = tile;
+            tile = std::find_if(
+                    tile, cache.tiles.end(), [l](const ObjectRef& ref)
+                    {
+                        return ref.layer != l;
+                    });
+            if (!obj.collision.accepts(index.categories[l]))
+            {
+                continue;
+            }
+            std::vector<GameObject>& layer = gs->layers[l];
+            if (index.dynamicLayers[l])
+            {
+                for (auto& objB: layer)
+                {
+                    collideWith(objB);
+                }
+                continue;
+            }
+
+            // a response can push obj out of the bounds, the layer is then tested in full, as
+            // if there were no cache, less the cached tiles already tested
+            bool covered = cache.covers(obj.GetCollider());
+            auto tested = first;
+            for (; covered && tested != tile; ++tested)
+            {
+                collideWith(layer[tested->index]);
+                covered = cache.covers(obj.GetCollider());
+            }
+            auto skip = first;
+            for (int i = 0; !covered && i < static_cast<int>(layer.size()); ++i)
+            {
+                if (skip != tested && skip->index == i)
+                {
+                    ++skip;
+                    continue;
+                }
+                collideWith(layer[i]);
+            }
+        }
+    }
+
+    // one object of a type known at compile time, so neither its behaviour nor its
+    // collision responses branch on the type
+    template<ObjectType T>
+    void updateAs(
+            const SDLState* state, GameState* gs, const Resources* res, GameObject& obj,
+            const float deltaTime)
+    {
+        if (obj.currentAnimation >= 0)
+        {
+            obj.animations[obj.currentAnimation].step(deltaTime);
+        }
+
+        // apply some gravity
+        if (obj.dynamic)
+        {
+            obj.velocity += glm::vec2(0, 500) * deltaTime;
+        }
+
+        const float currentDirection = updateBehaviour(
+                state, gs, res, obj, obj.get<DataOf<T>>(), deltaTime);
+
+        // an object always need a direction
+        if (currentDirection != 0)
+        {
+            obj.direction = currentDirection;
+        }
+        obj.velocity += currentDirection * obj.acceleration * deltaTime;
+        obj.velocity.x = glm::clamp(obj.velocity.x, -obj.maxSpeedX, obj.maxSpeedX);
+
+        // horizontal
+        obj.position.x += obj.velocity.x * deltaTime;
+        collideWithLayers<T>(res, gs, obj, true);
+        // vertical
+        obj.grounded = false;
+        obj.position.y += obj.velocity.y * deltaTime;
+        collideWithLayers<T>(res, gs, obj, false);
+    }
+
+    // what each event does once the tick's objects have all moved
+    struct EventHandler
+    {
+        GameState* gs;
+        const Resources* res;
+
+        // the object or nullptr if it is gone
+        GameObject* find(const ObjectHandle handle) const
+        {
+            const ObjectRef* ref = gs->registry.find(handle);
+            return ref != nullptr ? &gs->layers[ref->layer][ref->index] : nullptr;
+        }
+
+        void operator()(const events::Fired& e) const
+        {
+            gs->soundEvents.push_back({res->shoot, e.position});
+            gs->particleEvents.push_back({res->muzzle_flash, e.position, e.direction});
+        }
+
+        void operator()(const events::HitWall& e) const
+        {
+            gs->particleEvents.push_back({res->sparks, e.position, -e.direction});
+        }
+
+        void operator()(const events::Hit& e) const
+        {
+            GameObject* enemy = find(e.enemy);
+            if (enemy == nullptr)
+            {
+                return;
+            }
+            enemy->direction = -e.direction;
+            enemy->shouldFlash = true;
+            enemy->flashTimer.reset();
+            enemy->texture = res->texEnemyHit;
+            enemy->currentAnimation = res->ANIM_ENEMY_HIT;
+            if (e.fatal)
+            {
+                // the Killed right after plays its sound and particles
+                enemy->texture = res->texEnemyDie;
+                enemy->currentAnimation = res->ANIM_ENEMY_DIE;
+            }
+            else
+            {
+                gs->soundEvents.push_back({res->enemy_hit, e.position});
+                gs->particleEvents.push_back({res->enemy_blood, e.position, e.direction});
+            }
+        }
+
+        void operator()(const events::Killed& e) const
+        {
+            const GameObject* enemy = find(e.enemy);
+            if (enemy == nullptr)
+            {
+                return;
+            }
+            const glm::vec2 centre = enemy->position +
+                                     glm::vec2(enemy->collider.x + enemy->collider.w / 2,
+                                               enemy->collider.y + enemy->collider.h / 2);
+            gs->soundEvents.push_back({res->enemy_die, centre});
+            gs->particleEvents.push_back({res->enemy_gibs, centre, e.direction});
+        }
+
+        void operator()(const events::Pushed& e) const
+        {
+            if (GameObject* target = find(e.target))
+            {
+                target->velocity = e.velocity;
+            }
+        }
+    };
+}
+
+void processEvents(GameState* gs, const Resources* res)
+{
+    for (const GameplayEvent& event : gs->events)
+    {
+        std::visit(EventHandler{gs, res}, event);
+    }
+    gs->eventCount = static_cast<int>(gs->events.size());
+    gs->events.clear();
+}
+
+void fireBullet(GameState* gs, const Resources* res, const GameObject& shooter)
+{
+    // reuse an inactive slot, keeping its animation storage, so shooting doesn't allocate
+    const auto slot = std::ranges::find_if(
+            gs->bullets, [](const GameObject& b)
+            {
+                return b.get<BulletData>().state == BulletState::inactive;
+            });
+    GameObject& bullet = slot != gs->bullets.end() ? *slot : gs->bullets.emplace_back();
+    std::vector<Animation> animations = std::move(bullet.animations);
+    std::vector<ObjectRef> tiles = std::move(bullet.contacts.tiles);
+    bullet = GameObject();
+    bullet.animations = std::move(animations);
+    bullet.contacts.tiles = std::move(tiles);
+    bullet.animations.assign(res->bulletAnims.begin(), res->bulletAnims.end());
+    bullet.data = BulletData();
+    bullet.direction = shooter.direction;
+    bullet.texture = res->texBullet;
+    bullet.currentAnimation = res->ANIM_BULLET_MOVING;
+    bullet.collider = {0, 0, res->texBullet->rect.h, res->texBullet->rect.h};
+    bullet.collision = defaultCollision(ObjectType::bullet);
+    // bullets have random Y velocity
+    constexpr Sint32 yVariation = 40.f;
+    const Sint32 yVel = SDL_rand_r(&gs->randomState, yVariation) - yVariation / 2;
+    bullet.velocity = glm::vec2(shooter.velocity.x + 600.0f * shooter.direction, yVel);
+    bullet.maxSpeedX = 1000.0f;
+
+    // adjust bullet position (lerp)
+    constexpr float left = 0;
+    const float right = res->map->tileWidth - bullet.collider.w;
+    const float t = (shooter.direction + 1) / 2.0f; // 0 to 1
+    const float xOffset = left + right * t;
+    bullet.position = glm::vec2(
+            shooter.position.x + xOffset,
+            shooter.position.y + res->map->tileHeight / 2.0f + 1);
+    gs->events.push_back(
+            events::Fired{bullet.position + glm::vec2(0, bullet.collider.h / 2),
+                          shooter.direction});
+}
+
+GameObject createPlayer(const Resources* res, const glm::vec2 position, const int id)
+{
+    GameObject player;
+    player.position = position;
+    player.texture = res->texIdle;
+    player.data = PlayerData{.id = std::min(id, MAX_PLAYERS - 1)};
+    player.animations = res->playerAnims;
+    player.currentAnimation = res->ANIM_PLAYER_IDLE;
+    player.acceleration = glm::vec2(300.f, 0.f);
+    player.maxSpeedX = 100.f;
+    player.dynamic = true;
+    player.collider = {11, 6, 10, 26};
+    player.collision = defaultCollision(ObjectType::player);
+    return player;
+}
+
+void addPlayers(GameState* gs, const Resources* res, const int count)
+{
+    const int layer = gs->playerLayer();
+    const glm::vec2 position = gs->player().position;
+    for (auto players = std::ranges::count(gs->layers[layer], ObjectType::player,
+                                           &GameObject::type);
+         players < count; ++players)
+    {
+        spawnObject(
+                gs, layer,
+                createPlayer(
+                        res, position + glm::vec2(res->map->tileWidth * players, 0),
+                        static_cast<int>(players)));
+    }
+}
+
+GameObject createEnemy(const Resources* res, const glm::vec2 position)
+{
+    GameObject enemy;
+    enemy.position = position;
+    enemy.texture = res->texEnemy;
+    enemy.data = EnemyData();
+    enemy.currentAnimation = res->ANIM_ENEMY;
+    enemy.animations = res->enemyAnims;
+    enemy.collider = {10, 4, 12, 28};
+    enemy.collision = defaultCollision(ObjectType::enemy);
+    enemy.dynamic = true;
+    enemy.maxSpeedX = 15;
+    return enemy;
+}
+
+namespace
+{
+    // "enemy|level", "player, bullet" or a number like 0x6, fallback if it is none of these
+    uint32_t parseCategories(const std::string& text, const uint32_t fallback)
+    {
+        char* end = nullptr;
+        const unsigned long value = std::strtoul(text.c_str(), &end, 0);
+        if (end != text.c_str() && *end == '\0')
+        {
+            return static_cast<uint32_t>(value);
+        }
+
+        struct Name
+        {
+            std::string_view name;
+            ObjectType type;
+        };
+        constexpr Name NAMES[] = {
+                {"player", ObjectType::player}, {"level", ObjectType::level},
+                {"enemy", ObjectType::enemy}, {"bullet", ObjectType::bullet},
+        };
+        uint32_t categories = 0;
+        for (std::string_view rest = text; !rest.empty();)
+        {
+            const size_t separator = rest.find_first_of("|, ");
+            const std::string_view word = rest.substr(0, separator);
+            rest = separator == std::string_view::npos ? "" : rest.substr(separator + 1);
+            if (word.empty())
+            {
+                continue;
+            }
+            const auto itr = std::ranges::find(NAMES, word, &Name::name);
+            if (itr == std::end(NAMES))
+            {
+                SDL_Log("Unknown collision category %s", text.c_str());
+                return fallback;
+            }
+            categories |= collisionCategory(itr->type);
+        }
+        return categories;
+    }
+
+    // Tiled's collisionCategory and collisionMask properties, for whatever has them
+    void applyCollisionProperties(
+            CollisionFilter& filter, const std::vector<tmx::Property>& properties)
+    {
+        if (const std::string* category = tmx::findProperty(properties, "collisionCategory"))
+        {
+            filter.category = parseCategories(*category, filter.category);
+        }
+        if (const std::string* mask = tmx::findProperty(properties, "collisionMask"))
+        {
+            filter.mask = parseCategories(*mask, filter.mask);
+        }
+    }
+}
+
+std::vector<GameObject> createLayer(
+        const SDLState* state, GameState* gs, const Resources* res, const int index)
+{
+    struct LayerVisitor
+    {
+        const SDLState* state;
+        GameState* gs;
+        const Resources* res;
+        int index;
+
+        LayerVisitor(const SDLState* state, GameState* gs, const Resources* res, const int index)
+            : state(state), gs(gs), res(res), index(index)
+        {
+        }
+
+        // a tile, GameObject's data is LevelData unless told otherwise
+        GameObject createObject(const int r, const int c, const AtlasRegion* tex) const
+        {
+            GameObject o;
+            o.position = glm::vec2(c * res->map->tileWidth, r * res->map->tileHeight);
+            o.texture = tex;
+            o.collider = {0, 0, static_cast<float>(res->map->tileWidth),
+                          static_cast<float>(res->map->tileHeight)};
+            return o;
+        };
+
+        std::vector<GameObject> operator()(const tmx::Layer& layer) const
+        {
+            std::vector<GameObject> newLayer;
+            // read once, every tile of the layer gets the same
+            CollisionFilter collision = defaultCollision(ObjectType::level);
+            applyCollisionProperties(collision, layer.properties);
+            for (auto r = 0; r < res->map->mapHeight; ++r)
+            {
+                for (auto c = 0; c < res->map->mapWidth; ++c)
+                {
+                    // tile global ID
+                    const int tGid = layer.data[r * res->map->mapWidth + c];
+                    if (!tGid) // 0 = empty tile
+                    {
+                        continue;
+                    }
+                    // find the texture for that id
+                    const auto itr = std::ranges::find_if(
+                            res->tileSetTextures.begin(), res->tileSetTextures.end(),
+                            [tGid](const TileSetTextures& res_tst)
+                            {
+                                return tGid >= res_tst.firstgid && tGid < res_tst.firstgid
+                                       +
+                                       res_tst.textures.
+                                               size();
+                            }
+                            );
+                    assert(itr != res->tileSetTextures.end());
+                    const auto& [firstgid, textures] = *itr;
+                    const AtlasRegion* tex = textures[tGid - firstgid];
+                    // animated tiles share their gid's region, which shows the current frame
+                    if (const AtlasRegion* animated = res->tileAnimations.region(tGid))
+                    {
+                        tex = animated;
+                    }
+
+                    auto tile = createObject(r, c, tex);
+                    tile.collision = collision;
+                    if (layer.name != "Level") // foreground/background
+                    {
+                        tile.collider.w = tile.collider.h = 0;
+                    }
+
+                    newLayer.push_back(std::move(tile));
+                }
+            }
+            if (layer.name == "Level")
+            {
+                gs->flowField = FlowField(
+                        res->map->mapWidth, res->map->mapHeight, res->map->tileWidth,
+                        res->map->tileHeight, layer.data, ENEMY_CHASE_STEPS);
+            }
+            return newLayer;
+        }
+
+        std::vector<GameObject> operator()(const tmx::ObjectGroup& objectGroup) const
+        {
+            std::vector<GameObject> newLayer;
+            int players = 0;
+            for (const tmx::LayerObject& obj: objectGroup.objects)
+            {
+                glm::vec2 objPos(
+                        obj.x - res->map->tileWidth / 2.0f, obj.y - res->map->tileHeight / 2.0f);
+
+                if (obj.type == "player")
+                {
+                    newLayer.push_back(createPlayer(res, objPos, players++));
+                }
+                else if (obj.type == "enemy")
+                {
+                    newLayer.push_back(createEnemy(res, objPos));
+                }
+                else
+                {
+                    continue;
+                }
+                // the group's properties apply to all of its objects, an object's own to it
+                applyCollisionProperties(newLayer.back().collision, objectGroup.properties);
+                applyCollisionProperties(newLayer.back().collision, obj.properties);
+            }
+            return newLayer;
+        }
+    };
+
+    return std::visit(LayerVisitor(state, gs, res, index), res->map->layers[index]);
+}
+
+void createTiles(const SDLState* state, GameState* gs, const Resources* res)
+{
+    gs->layers.resize(res->map->layers.size());
+    for (int i = 0; i < static_cast<int>(res->map->layers.size()); ++i)
+    {
+        setLayer(gs, i, createLayer(state, gs, res, i));
+    }
+    gs->objectIndex = {};
+
+    assert(gs->registry.find(gs->playerHandle) != nullptr);
+}
+
+void setLayer(GameState* gs, const int index, std::vector<GameObject> objects)
+{
+    gs->registry.removeLayer(index);
+    std::vector<GameObject>& layer = gs->layers[index] = std::move(objects);
+    for (int i = 0; i < static_cast<int>(layer.size()); ++i)
+    {
+        GameObject& obj = layer[i];
+        obj.handle = obj.dynamic ? gs->registry.add({index, i}) : ObjectHandle{};
+        if (obj.type() == ObjectType::player)
+        {
+            gs->playerHandle = obj.handle;
+        }
+    }
+}
+
+ObjectHandle spawnObject(GameState* gs, const int layer, GameObject obj)
+{
+    std::vector<GameObject>& objects = gs->layers[layer];
+    obj.handle = obj.dynamic
+                     ? gs->registry.add({layer, static_cast<int>(objects.size())})
+                     : ObjectHandle{};
+    objects.push_back(std::move(obj));
+    return objects.back().handle;
+}
+
+void destroyObject(GameState* gs, const ObjectHandle handle)
+{
+    if (gs->registry.find(handle) != nullptr)
+    {
+        gs->destroyQueue.push_back(handle);
+    }
+}
+
+void destroyQueued(GameState* gs)
+{
+    for (const ObjectHandle handle: gs->destroyQueue)
+    {
+        const ObjectRef* ref = gs->registry.find(handle);
+        if (ref == nullptr)
+        {
+            continue; // destroyed twice in one tick
+        }
+        std::vector<GameObject>& layer = gs->layers[ref->layer];
+        const int index = ref->index;
+        gs->registry.remove(handle);
+        // swap and pop keeps the layer dense, only the last object moves
+        if (index != static_cast<int>(layer.size()) - 1)
+        {
+            layer[index] = std::move(layer.back());
+            gs->registry.move(layer[index].handle, index);
+        }
+        layer.pop_back();
+    }
+    gs->destroyQueue.clear();
+}
+
+bool reloadMap(const SDLState* state, GameState* gs, Resources* res)
+{
+    std::unique_ptr<tmx::Map> map = tmx::loadMap(res->mapPath, res->tileSetCache);
+    if (!map)
+    {
+        // probably saved halfway, the next write reloads it
+        SDL_Log("Error reloading map %s", res->mapPath.c_str());
+        return false;
+    }
+    const bool reshaped = map->mapWidth != res->map->mapWidth ||
+                          map->mapHeight != res->map->mapHeight ||
+                          map->tileWidth != res->map->tileWidth ||
+                          map->tileHeight != res->map->tileHeight ||
+                          map->tileSets != res->map->tileSets ||
+                          map->layers.size() != res->map->layers.size();
+    const std::unique_ptr<tmx::Map> oldMap = std::move(res->map);
+    res->map = std::move(map);
+    res->loadTileSets();
+    res->atlas.build(state->renderer);
+    res->tileAnimations.update(0);
+
+    // the player keeps going from where it is, only the layers that changed are rebuilt
+    const GameObject player = gs->player();
+    const int layerCount = static_cast<int>(res->map->layers.size());
+    for (int i = layerCount; i < static_cast<int>(gs->layers.size()); ++i)
+    {
+        gs->registry.removeLayer(i);
+    }
+    gs->layers.resize(layerCount);
+    for (int i = 0; i < layerCount; ++i)
+    {
+        if (reshaped || res->map->layers[i] != oldMap->layers[i])
+        {
+            setLayer(gs, i, createLayer(state, gs, res, i));
+        }
+    }
+    if (gs->registry.find(gs->playerHandle) == nullptr)
+    {
+        // the map lost its player, keep ours in the last layer
+        gs->playerHandle = spawnObject(gs, layerCount - 1, player);
+    }
+    else
+    {
+        const ObjectHandle handle = gs->player().handle;
+        gs->player() = player;
+        gs->player().handle = handle;
+    }
+
+    // a rebuilt layer can reuse the storage of the one it replaced
+    gs->objectIndex = {};
+    gs->mapViewport.y = res->map->mapHeight * res->map->tileHeight - gs->mapViewport.h;
+    res->loadParallaxLayers(state->renderer);
+    return true;
+}
+
+bool reloadAsset(const SDLState* state, GameState* gs, Resources* res, const std::string& path)
+{
+    try
+    {
+        const std::string extension = std::filesystem::path(path).extension().string();
+        if (extension == ".png")
+        {
+            return res->reloadTexture(state->renderer, path);
+        }
+        if (extension == ".tsx")
+        {
+            // tiles may have been added or removed, so the map is rebuilt with it
+            res->tileSetCache.erase(path);
+            return reloadMap(state, gs, res);
+        }
+        if (path == res->mapPath)
+        {
+            return reloadMap(state, gs, res);
+        }
+    }
+    catch (const std::runtime_error& e)
+    {
+        // a broken asset shouldn't end the game, the previous version stays in use
+        SDL_Log("Reload of %s failed: %s", path.c_str(), e.what());
+    }
+    return false;
+}
+
+void drawParallaxBackground(
+        const SDLState* state, const GameState* gs, const Resources* res, SpriteBatch& batch)
+{
+    // background layers go below every map layer, in the order they are listed
+    const int layerCount = static_cast<int>(res->parallaxLayers.size());
+    for (int i = 0; i < layerCount; ++i)
+    {
+        const auto& [texture, scrollFactor, y] = res->parallaxLayers[i];
+        const float w = static_cast<float>(texture->w);
+        const float h = static_cast<float>(texture->h);
+
+        // derived from the camera, so it doesn't drift with a variable deltaTime
+        float offset = -std::fmod(gs->mapViewport.x * scrollFactor, w);
+        if (offset > 0)
+        {
+            offset -= w;
+        }
+
+        // repeat the texture until the screen is covered
+        const SDL_FRect src{0, 0, w, h};
+        for (float x = offset; x < state->logW; x += w)
+        {
+            batch.draw(
+                    texture, src, {x, y, w, h}, SDL_FLIP_NONE, {1.0f, 1.0f, 1.0f, 1.0f},
+                    i - layerCount);
+        }
+    }
+}
+
+SDL_FRect activationRegion(const SDL_FRect& mapViewport)
+{
+    return {
+            mapViewport.x - ACTIVATION_MARGIN, mapViewport.y - ACTIVATION_MARGIN,
+            mapViewport.w + 2 * ACTIVATION_MARGIN, mapViewport.h + 2 * ACTIVATION_MARGIN
+    };
+}
+
+void updateSleep(
+        GameState* gs, const SDL_FRect& activeRegion, GameObject& obj, const float deltaTime)
+{
+    const SDL_FRect rect = obj.GetCollider();
+    const EnemyData& d = obj.get<EnemyData>();
+    if (!SDL_HasRectIntersectionFloat(&activeRegion, &rect))
+    {
+        // nobody will see it again, it goes now instead of lying asleep forever
+        if (d.state == EnemyState::dead)
+        {
+            destroyObject(gs, obj.handle);
+        }
+        obj.sleeping = true;
+        obj.restTime = 0;
+        return;
+    }
+
+    if (!obj.sleeping)
+    {
+        // only idle enemies can rest, corpses stay awake until they are removed
+        if (d.state == EnemyState::shambling && obj.grounded && obj.velocity.x == 0)
+        {
+            obj.restTime += deltaTime;
+            obj.sleeping = obj.restTime >= REST_TIME_TO_SLEEP;
+        }
+        else
+        {
+            obj.restTime = 0;
+        }
+        return;
+    }
+
+    // it was sleeping only because it was outside the activation region
+    if (obj.restTime < REST_TIME_TO_SLEEP)
+    {
+        obj.wake();
+        return;
+    }
+
+    // resting enemies wake up when the player comes within chasing distance
+    const glm::ivec2 cell = gs->flowField.cellAt({rect.x + rect.w / 2, rect.y + rect.h - 1});
+    if (d.state != EnemyState::dead && gs->flowField.step(cell).distance >= 0)
+    {
+        obj.wake();
+        return;
+    }
+
+    // keep resting enemies animated while they sleep
+    if (obj.currentAnimation >= 0)
+    {
+        obj.animations[obj.currentAnimation].step(deltaTime);
+    }
+}
+
+PlayerInput readKeyboard(const bool* keys)
+{
+    PlayerInput input;
+    const std::pair<SDL_Scancode, PlayerInput::Button> bindings[] = {
+            {SDL_SCANCODE_A, PlayerInput::left}, {SDL_SCANCODE_D, PlayerInput::right},
+            {SDL_SCANCODE_K, PlayerInput::jump}, {SDL_SCANCODE_J, PlayerInput::shoot},
+    };
+    for (const auto& [key, button]: bindings)
+    {
+        if (keys[key])
+        {
+            input.buttons |= button;
+        }
+    }
+    return input;
+}
+
+void updateViewport(GameState* gs, const Resources* res)
+{
+    float sum = 0;
+    int players = 0;
+    for (const GameObject& obj: gs->layers[gs->playerLayer()])
+    {
+        if (obj.type() == ObjectType::player)
+        {
+            sum += obj.position.x;
+            ++players;
+        }
+    }
+    const float x = players > 0 ? sum / players : gs->player().position.x;
+    gs->mapViewport.x = x + res->map->tileWidth / 2.0f - gs->mapViewport.w / 2.0f;
+}
+
+void indexObjects(GameState* gs)
+{
+    ObjectIndex& index = gs->objectIndex;
+    const bool current = std::ranges::equal(
+            gs->layers, index.layers, [](const std::vector<GameObject>& layer, const auto& seen)
+            {
+                return layer.data() == seen.first && layer.size() == seen.second;
+            });
+    if (current)
+    {
+        return;
+    }
+
+    for (auto& refs: index.byType)
+    {
+        refs.clear();
+    }
+    // contact caches only hold tiles, objects spawned or destroyed in the layers of dynamic
+    // objects leave them as they are
+    bool tilesChanged = index.layers.size() != gs->layers.size();
+    index.layers.resize(gs->layers.size());
+    index.categories.assign(gs->layers.size(), 0);
+    index.dynamicLayers.resize(gs->layers.size());
+    for (int l = 0; l < static_cast<int>(gs->layers.size()); ++l)
+    {
+        const std::vector<GameObject>& layer = gs->layers[l];
+        bool dynamic = false;
+        for (int i = 0; i < static_cast<int>(layer.size()); ++i)
+        {
+            const GameObject& obj = layer[i];
+            if (obj.dynamic)
+            {
+                index.byType[static_cast<size_t>(obj.type())].push_back({l, i});
+                dynamic = true;
+            }
+            if (obj.collider.w != 0 && obj.collider.h != 0)
+            {
+                index.categories[l] |= obj.collision.category;
+            }
+        }
+        const std::pair<const GameObject*, size_t> seen(layer.data(), layer.size());
+        tilesChanged |= dynamic != index.dynamicLayers[l] ||
+                        (!dynamic && seen != index.layers[l]);
+        index.layers[l] = seen;
+        index.dynamicLayers[l] = dynamic;
+    }
+    if (tilesChanged)
+    {
+        ++gs->layersVersion;
+    }
+}
+
+void updateGame(const SDLState* state, GameState* gs, const Resources* res, const float deltaTime)
+{
+    // enemies follow the flow field, which only changes when the player changes cell
+    const SDL_FRect playerRect = gs->player().GetCollider();
+    const glm::ivec2 playerCell = gs->flowField.cellAt(
+            {playerRect.x + playerRect.w / 2, playerRect.y + playerRect.h - 1});
+    const uint64_t flowStart = SDL_GetPerformanceCounter();
+    if (gs->flowField.setTarget(playerCell))
+    {
+        gs->flowFieldMs = (SDL_GetPerformanceCounter() - flowStart) * 1000.0f /
+                          SDL_GetPerformanceFrequency();
+    }
+
+    // each type in a loop of its own, with its update and collision responses picked at
+    // compile time. Players first, so enemies chase where they are this tick.
+    indexObjects(gs);
+    gs->collisionTests = 0;
+    gs->contactScans = 0;
+    const auto& byType = gs->objectIndex.byType;
+    for (const auto& [l, i]: byType[static_cast<size_t>(ObjectType::player)])
+    {
+        updateAs<ObjectType::player>(state, gs, res, gs->layers[l][i], deltaTime);
+    }
+
+    // enemies away from the viewport sleep and skip update() and collision entirely
+    const SDL_FRect activeRegion = activationRegion(gs->mapViewport);
+    const auto& enemies = byType[static_cast<size_t>(ObjectType::enemy)];
+    gs->enemyCount = static_cast<int>(enemies.size());
+    gs->awakeEnemies = 0;
+    for (const auto& [l, i]: enemies)
+    {
+        GameObject& obj = gs->layers[l][i];
+        updateSleep(gs, activeRegion, obj, deltaTime);
+        if (!obj.sleeping)
+        {
+            ++gs->awakeEnemies;
+            updateAs<ObjectType::enemy>(state, gs, res, obj, deltaTime);
+        }
+    }
+
+    // inactive bullets are reset when they are fired again, nothing needs them to move
+    for (auto& bullet: gs->bullets)
+    {
+        if (bullet.get<BulletData>().state != BulletState::inactive)
+        {
+            updateAs<ObjectType::bullet>(state, gs, res, bullet, deltaTime);
+        }
+    }
+
+    // what the collisions did to the objects that were run into, and the sounds and
+    // particles of it all, in the order it happened
+    processEvents(gs, res);
+
+    // the loops above go by position in the layers, so nothing moves until they are done
+    destroyQueued(gs);
+}
+
+void drawGame(SDLState* state, GameState* gs, const Resources* res, const float deltaTime)
+{
+    SDL_SetRenderDrawColor(state->renderer, 20, 10, 30, 255);
+    SDL_RenderClear(state->renderer);
+
+    SpriteBatch spriteBatch(state->frameArena.resource(), state->batchStats.sprites);
+
+    SDL_RenderTexture(state->renderer, res->texBg1, nullptr, nullptr);
+    drawParallaxBackground(state, gs, res, spriteBatch);
+
+    // sprites are collected and drawn in one go, sorted by layer and texture
+    const int layerCount = static_cast<int>(gs->layers.size());
+    for (int l = 0; l < layerCount; ++l)
+    {
+        for (auto& obj: gs->layers[l])
+        {
+            drawObject(
+                    state, gs, spriteBatch, obj, l, res->map->tileWidth, res->map->tileHeight,
+                    deltaTime);
+        }
+    }
+
+    // bullets are drawn on top of all layers
+    for (auto& bullet: gs->bullets)
+    {
+        if (bullet.get<BulletData>().state != BulletState::inactive)
+        {
+            drawObject(
+                    state, gs, spriteBatch, bullet, layerCount, bullet.collider.w,
+                    bullet.collider.h, deltaTime);
+        }
+    }
+
+    spriteBatch.flush(state->renderer);
+    state->batchStats = spriteBatch.getStats();
+    // on top of everything, like bullets
+    gs->particles.draw(state->renderer, res->emitters, gs->mapViewport);
+
+    if (gs->debugMode)
+    {
+        for (const auto& layer: gs->layers)
+        {
+            for (const auto& obj: layer)
+            {
+                drawDebug(state, gs, obj);
+            }
+        }
+        for (const auto& bullet: gs->bullets)
+        {
+            if (bullet.get<BulletData>().state != BulletState::inactive)
+            {
+                drawDebug(state, gs, bullet);
+            }
+        }
+    }
+}
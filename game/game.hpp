@@ -0,0 +1,305 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <SDL3/SDL.h>
+#include <SDL3_mixer/SDL_mixer.h>
+#include <autorelease/AutoRelease.hpp>
+
+#include "atlas.hpp"
+#include "audio.hpp"
+#include "events.hpp"
+#include "flowfield.hpp"
+#include "gameobject.hpp"
+#include "memory.hpp"
+#include "particles.hpp"
+#include "registry.hpp"
+#include "resolution.hpp"
+#include "spritebatch.hpp"
+#include "tiles.hpp"
+#include "tmx.hpp"
+
+// buttons a player holds during one tick, the simulation reads these instead of the keyboard
+struct PlayerInput
+{
+    enum Button : uint8_t
+    {
+        left = 1, right = 2, jump = 4, shoot = 8
+    };
+
+    uint8_t buttons{};
+
+    [[nodiscard]] bool held(const Button button) const
+    {
+        return buttons & button;
+    }
+
+    bool operator==(const PlayerInput&) const = default;
+};
+
+// players in a map beyond this share the last input
+constexpr int MAX_PLAYERS = 4;
+
+typedef struct SDLState
+{
+    AutoRelease<bool> sdl_init;
+    AutoRelease<SDL_Window*> window;
+    AutoRelease<SDL_Renderer*> renderer;
+    AutoRelease<bool> mix_init;
+    AutoRelease<MIX_Mixer*> mixer;
+    // the game is drawn into its texture, after the renderer so it is destroyed first
+    ResolutionScaler resolution{};
+    // transient allocations of the current frame
+    FrameArena frameArena{};
+    SpriteBatch::Stats batchStats{}; // last frame
+    size_t allocationMark{}, frameAllocations{};
+    std::string reloadedPath{}; // last asset reloaded while running
+    float reloadMs{};
+    int width{}, height{};
+    int logW{}, logH{}; // logical width/height
+    const bool* keys{};
+    uint64_t prevTime{};
+    bool fullscreen{};
+
+    ~SDLState() = default;
+} SDLState;
+
+// the dynamic objects of every type, so each type is updated in a loop of its own
+struct ObjectIndex
+{
+    std::array<std::vector<ObjectRef>, OBJECT_TYPE_COUNT> byType{};
+    // storage and size of every layer when indexed, the index is rebuilt when they change
+    std::vector<std::pair<const GameObject*, size_t>> layers{};
+    // collision categories of everything solid in each layer
+    std::vector<uint32_t> categories{};
+    // layers with dynamic objects in them, never in a ContactCache
+    std::vector<bool> dynamicLayers{};
+};
+
+struct GameState
+{
+    // the queues are reserved this much once, enough for a busy tick, so playing never grows
+    // them. Sounds and bursts wait for the end of the frame, which can run a few ticks.
+    static constexpr size_t EVENT_CAPACITY = 256;
+    static constexpr size_t EFFECT_CAPACITY = 1024;
+
+    std::vector<std::vector<GameObject>> layers{};
+    std::vector<GameObject> bullets{};
+    // where the dynamic objects in layers are, whatever compaction did to them
+    ObjectRegistry registry{};
+    ObjectHandle playerHandle{};
+    // objects destroyed this tick, removed from their layers at the end of it
+    std::vector<ObjectHandle> destroyQueue{};
+    SDL_FRect mapViewport{};
+    // shared by all enemies to chase the player
+    FlowField flowField{};
+    float flowFieldMs{}; // time of the last recompute
+    // what happened this tick, turned into reactions, sounds and particles after it
+    std::vector<GameplayEvent> events{};
+    // sounds requested this frame, played by the AudioSystem at the end of the frame
+    std::vector<SoundEvent> soundEvents{};
+    // hits, deaths and shots, spawned into particles at the end of the update
+    std::vector<ParticleEvent> particleEvents{};
+    ParticleSystem particles{};
+    int enemyCount{}, awakeEnemies{}; // last update
+    int collisionTests{};               // rects tested for overlap, last update
+    int contactScans{};                 // contact caches found again, last update
+    int eventCount{};                   // gameplay events, last update
+    // reset it after changing an object's type in place
+    ObjectIndex objectIndex{};
+    // counts the rebuilds of objectIndex that changed a tile layer, a contact cache found
+    // before the last one is stale
+    uint32_t layersVersion{};
+    // what each player holds this tick, by PlayerData::id
+    std::array<PlayerInput, MAX_PLAYERS> inputs{};
+    // gameplay randomness comes from here, so a restored snapshot plays out the same way
+    Uint64 randomState = 1;
+    bool debugMode{};
+
+    GameState() : GameState(640, 480, 480)
+    {
+    }
+
+    explicit GameState(const float viewPortWidth, const float viewPortHeight, const float mapHeight)
+    {
+        mapViewport = {0, mapHeight - viewPortHeight, viewPortWidth, viewPortHeight};
+        // and bullets for as many as are usually in flight
+        bullets.reserve(64);
+        events.reserve(EVENT_CAPACITY);
+        soundEvents.reserve(EFFECT_CAPACITY);
+        particleEvents.reserve(EFFECT_CAPACITY);
+    }
+
+    GameObject& player()
+    {
+        const ObjectRef* ref = registry.find(playerHandle);
+        assert(ref != nullptr);
+        return layers[ref->layer][ref->index];
+    }
+
+    [[nodiscard]] int playerLayer() const
+    {
+        const ObjectRef* ref = registry.find(playerHandle);
+        assert(ref != nullptr);
+        return ref->layer;
+    }
+};
+
+// a background layer that scrolls slower than the map, repeated across the screen
+struct ParallaxLayer
+{
+    SDL_Texture* texture{};
+    float scrollFactor{}; // fraction of the camera movement
+    float y{};            // screen position of the top edge
+};
+
+struct Resources
+{
+    // player
+    const int ANIM_PLAYER_IDLE = 0;
+    const int ANIM_PLAYER_RUNNING = 1;
+    const int ANIM_PLAYER_SLIDE = 2;
+    const int ANIM_PLAYER_SHOOT = 3;
+    const int ANIM_PLAYER_SLIDE_SHOOT = 4;
+    std::vector<Animation> playerAnims;
+
+    // bullet
+    const int ANIM_BULLET_MOVING = 0;
+    const int ANIM_BULLET_HIT = 1;
+    std::vector<Animation> bulletAnims;
+
+    // enemy
+    const int ANIM_ENEMY = 0;
+    const int ANIM_ENEMY_HIT = 1;
+    const int ANIM_ENEMY_DIE = 2;
+    std::vector<Animation> enemyAnims;
+
+    std::vector<AutoRelease<SDL_Texture*>> textures;
+    std::unordered_map<std::string, size_t> texturePaths{}; // index in textures
+    // sprite sheets and tiles, packed together so they can be batched
+    TextureAtlas atlas{};
+
+    // player
+    const AtlasRegion* texIdle{};
+    const AtlasRegion* texRun{};
+    const AtlasRegion* texSlide{};
+    // player shooting
+    const AtlasRegion* texShoot{}; // idle
+    const AtlasRegion* texRunShoot{};
+    const AtlasRegion* texSlideShoot{};
+
+    // tiles
+    const AtlasRegion* texBrick{};
+    const AtlasRegion* texGrass{};
+    const AtlasRegion* texGround{};
+    const AtlasRegion* texPanel{};
+
+    // backgrounds
+    SDL_Texture* texBg1{};
+    SDL_Texture* texBg2{};
+    SDL_Texture* texBg3{};
+    SDL_Texture* texBg4{};
+    // back to front
+    std::vector<ParallaxLayer> parallaxLayers{};
+
+    // bullets
+    const AtlasRegion* texBullet{};
+    const AtlasRegion* texBulletHit{};
+
+    // enemy
+    const AtlasRegion* texEnemy{};
+    const AtlasRegion* texEnemyHit{};
+    const AtlasRegion* texEnemyDie{};
+
+    // Audio
+    AudioSystem audio{};
+
+    Sound_ID music{};
+    Sound_ID enemy_hit{};
+    Sound_ID enemy_die{};
+    Sound_ID shoot{};
+
+    // particle effects
+    std::vector<ParticleEmitter> emitters{};
+    Emitter_ID sparks{};      // bullet hitting a wall
+    Emitter_ID enemy_blood{}; // bullet hitting an enemy
+    Emitter_ID enemy_gibs{};  // enemy dying
+    Emitter_ID muzzle_flash{};
+
+    // Tiled map
+    std::string mapPath{};
+    std::unique_ptr<tmx::Map> map{};
+    tmx::TileSetCache tileSetCache{};
+    std::vector<TileSetTextures> tileSetTextures{};
+    TileAnimations tileAnimations{};
+
+    SDL_Texture* loadTexture(SDL_Renderer* renderer, const std::string& filepath);
+    void load(const SDLState* state, const std::string& filepath);
+    // tiles of every tileset in the map, added to the atlas, and their animations
+    void loadTileSets();
+    // from the map's image layers, the built in backgrounds if it has none
+    void loadParallaxLayers(SDL_Renderer* renderer);
+    // reads a texture or atlas sheet from disk again, false if it isn't one of ours
+    bool reloadTexture(SDL_Renderer* renderer, const std::string& filepath);
+
+    ~Resources() = default;
+};
+
+void drawObject(
+        const SDLState* state, const GameState* gs, SpriteBatch& batch, GameObject& obj,
+        int layer, float width, float height, float deltaTime);
+void drawDebug(const SDLState* state, const GameState* gs, const GameObject& obj);
+void createTiles(const SDLState* state, GameState* gs, const Resources* res);
+// the objects of map layer index, updates the flow field if it has the level
+std::vector<GameObject> createLayer(
+        const SDLState* state, GameState* gs, const Resources* res, int index);
+// replaces layer index, the dynamic objects in it get handles and the last player becomes
+// gs->playerHandle. Handles to what the layer held before find nothing from then on.
+void setLayer(GameState* gs, int index, std::vector<GameObject> objects);
+// adds obj at the end of layer, with a handle if it is dynamic
+ObjectHandle spawnObject(GameState* gs, int layer, GameObject obj);
+// the object is removed at the end of the tick, until then it stays where it is.
+// Handles already destroyed are ignored.
+void destroyObject(GameState* gs, ObjectHandle handle);
+// removes everything destroyObject() queued, the last object of its layer takes its place
+void destroyQueued(GameState* gs);
+// reads res->mapPath again and rebuilds the layers that changed, keeping the player
+bool reloadMap(const SDLState* state, GameState* gs, Resources* res);
+// picks up a changed file under data/, false if it isn't in use or failed to load
+bool reloadAsset(const SDLState* state, GameState* gs, Resources* res, const std::string& path);
+GameObject createPlayer(const Resources* res, glm::vec2 position, int id);
+// adds players next to the first until the player layer has count of them
+void addPlayers(GameState* gs, const Resources* res, int count);
+GameObject createEnemy(const Resources* res, glm::vec2 position);
+// takes an inactive slot in gs->bullets, or adds one, and queues an events::Fired
+void fireBullet(GameState* gs, const Resources* res, const GameObject& shooter);
+// acts on gs->events in the order they happened and clears them: hit enemies react and
+// sounds and particles are queued
+void processEvents(GameState* gs, const Resources* res);
+void drawParallaxBackground(
+        const SDLState* state, const GameState* gs, const Resources* res, SpriteBatch& batch);
+SDL_FRect activationRegion(const SDL_FRect& mapViewport);
+void updateSleep(GameState* gs, const SDL_FRect& activeRegion, GameObject& obj, float deltaTime);
+PlayerInput readKeyboard(const bool* keys);
+// centres the viewport between the players, it decides who is awake so it is simulation state
+void updateViewport(GameState* gs, const Resources* res);
+// brings gs->objectIndex up to date with the layers, cheap when none was added to or replaced
+void indexObjects(GameState* gs);
+// one simulation step of everything awake, without drawing
+void updateGame(const SDLState* state, GameState* gs, const Resources* res, float deltaTime);
+// clears the screen and draws the world, the caller presents it
+void drawGame(SDLState* state, GameState* gs, const Resources* res, float deltaTime);
+
+// enemies chase the player when it is this many flow field steps away, about the 100 pixels
+// they used to chase from in a straight line
+constexpr int ENEMY_CHASE_STEPS = 3;
+// enemies further than this from the viewport are put to sleep
+constexpr float ACTIVATION_MARGIN = 128.0f;
+// grounded and stationary enemies fall asleep after resting this long
+constexpr float REST_TIME_TO_SLEEP = 0.5f;
+// objects keep the tiles found this far around them until they move further
+constexpr float CONTACT_MARGIN = 16.0f;
@@ -4,3 +4,9 @@ SDL_FRect GameObject::GetCollider() const
 {
     return {position.x + collider.x, position.y + collider.y, collider.w, collider.h};
 }
+
+void GameObject::wake()
+{
+    sleeping = false;
+    restTime = 0;
+}
@@ -1,9 +1,14 @@
 #pragma once
+#include <cassert>
+#include <cstdint>
+#include <variant>
 #include <vector>
 #include <SDL3/SDL.h>
 #include <glm/glm.hpp>
 
 #include "animation.hpp"
+#include "atlas.hpp"
+#include "registry.hpp"
 
 enum class PlayerState
 {
@@ -22,6 +27,7 @@ enum class EnemyState
 
 struct PlayerData
 {
+    int id{}; // which of GameState::inputs drives it
     PlayerState state = PlayerState::idle;
     Timer weaponTimer{0.1f};
 };
@@ -34,6 +40,7 @@ struct EnemyData
 {
     EnemyState state = EnemyState::shambling;
     Timer damagedTimer{0.5f};
+    Timer corpseTimer{3.0f}; // from the end of the death animation until it is removed
     int healthPoints{100};
 };
 
@@ -42,38 +49,123 @@ struct BulletData
     BulletState state = BulletState::moving;
 };
 
-union ObjectData
+enum class ObjectType
 {
-    PlayerData player;
-    LevelData level;
-    EnemyData enemy;
-    BulletData bullet;
+    player, level, enemy, bullet
 };
 
-enum class ObjectType
+constexpr int OBJECT_TYPE_COUNT = 4;
+
+// what only one type of object has, listed in ObjectType order so the index is the type
+using ObjectData = std::variant<PlayerData, LevelData, EnemyData, BulletData>;
+static_assert(std::variant_size_v<ObjectData> == OBJECT_TYPE_COUNT);
+
+// the data of an ObjectType, known at compile time
+template<ObjectType T>
+using DataOf = std::variant_alternative_t<static_cast<size_t>(T), ObjectData>;
+
+// which types of objects run into which, a row is the moving object and a column what it
+// touches. Pairs left out are never tested, whatever their colliders.
+constexpr bool COLLISION_PAIRS[OBJECT_TYPE_COUNT][OBJECT_TYPE_COUNT] = {
+        // player, level, enemy, bullet
+        {false, true, true, false},   // player
+        {false, false, false, false}, // level, tiles never move
+        {true, true, true, false},    // enemy
+        {false, true, true, false},   // bullet
+};
+
+// An object is tested against another only if its mask has a bit of the other's category.
+// Every type is its own category by default, maps can change both.
+struct CollisionFilter
 {
-    player, level, enemy, bullet
+    uint32_t category{}, mask{};
+
+    [[nodiscard]] bool accepts(const uint32_t categories) const
+    {
+        return (mask & categories) != 0;
+    }
+};
+
+constexpr uint32_t collisionCategory(const ObjectType type)
+{
+    return 1u << static_cast<int>(type);
+}
+
+// a type's category and the categories of everything COLLISION_PAIRS lets it touch
+constexpr CollisionFilter defaultCollision(const ObjectType type)
+{
+    CollisionFilter filter{.category = collisionCategory(type)};
+    for (int other = 0; other < OBJECT_TYPE_COUNT; ++other)
+    {
+        if (COLLISION_PAIRS[static_cast<int>(type)][other])
+        {
+            filter.mask |= collisionCategory(static_cast<ObjectType>(other));
+        }
+    }
+    return filter;
+}
+
+// The solid tiles around an object, found with one scan of the layers and reused for as
+// long as the object stays inside bounds, so its collision passes only test tiles it can
+// touch. Layers with dynamic objects in them are always tested in full.
+struct ContactCache
+{
+    SDL_FRect bounds{};
+    uint32_t version{}; // GameState::layersVersion it was found in, 0 for never
+    std::vector<ObjectRef> tiles{}; // by layer and index, the order a full scan meets them
+
+    [[nodiscard]] bool covers(const SDL_FRect& rect) const
+    {
+        return rect.x >= bounds.x && rect.y >= bounds.y &&
+               rect.x + rect.w <= bounds.x + bounds.w && rect.y + rect.h <= bounds.y + bounds.h;
+    }
 };
 
 struct GameObject
 {
-    ObjectType type = ObjectType::level;
-    ObjectData data{.level = LevelData{}};
+    ObjectData data{LevelData{}};
+    ObjectHandle handle{}; // null for tiles and bullets, which are never destroyed
     glm::vec2 position{}, velocity{}, acceleration{};
     float direction = 1;
     float maxSpeedX = 0;
     std::vector<Animation> animations{};
     // if currentAnimation == -1, will draw the spriteFrame index from object texture
     int currentAnimation = -1;
-    SDL_Texture* texture = nullptr;
+    const AtlasRegion* texture = nullptr; // sprite sheet inside the texture atlas
     bool dynamic{};
     SDL_FRect collider{};
+    CollisionFilter collision = defaultCollision(ObjectType::level);
+    ContactCache contacts{}; // dynamic objects only
     bool grounded{};
     Timer flashTimer{0.05f}; // object blink on hit
     bool shouldFlash{};
     // index in texture to draw if currentAnimation == -1
     int spriteFrame = 1;
+    // sleeping objects skip update() until the viewport approaches or something touches them
+    bool sleeping{};
+    float restTime{}; // seconds spent grounded and stationary
 
     GameObject() = default;
     SDL_FRect GetCollider() const;
+    void wake();
+
+    [[nodiscard]] ObjectType type() const
+    {
+        return static_cast<ObjectType>(data.index());
+    }
+
+    // the data of a type the object is known to be, unchecked in release builds
+    template<typename T>
+    T& get()
+    {
+        assert(std::holds_alternative<T>(data));
+        return *std::get_if<T>(&data);
+    }
+
+    template<typename T>
+    const T& get() const
+    {
+        assert(std::holds_alternative<T>(data));
+        return *std::get_if<T>(&data);
+    }
 };
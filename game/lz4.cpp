@@ -0,0 +1,188 @@
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    constexpr size_t MIN_MATCH = 4;
+    // the format wants the last 5 bytes as literals and no match starting in the last 12
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MATCH_LIMIT = 12;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr int HASH_BITS = 12;
+    // short copies are done this long when there is room, a fixed size copy is much faster
+    constexpr size_t FAST_COPY = 16;
+
+    uint32_t read32(const std::byte* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(const uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // lengths of 15 and more continue in bytes of 255 and a last one below it
+    void putLength(std::vector<std::byte>& out, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            out.push_back(std::byte{255});
+        }
+        out.push_back(static_cast<std::byte>(length));
+    }
+
+    void putSequence(
+            std::vector<std::byte>& out, const std::byte* literals, const size_t literalCount,
+            const size_t offset, const size_t matchLength)
+    {
+        const size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+        const size_t token = std::min<size_t>(literalCount, 15) << 4 |
+                             std::min<size_t>(matchCode, 15);
+        out.push_back(static_cast<std::byte>(token));
+        if (literalCount >= 15)
+        {
+            putLength(out, literalCount - 15);
+        }
+        out.insert(out.end(), literals, literals + literalCount);
+        if (matchLength == 0)
+        {
+            return; // the last sequence has no match
+        }
+        out.push_back(static_cast<std::byte>(offset & 0xff));
+        out.push_back(static_cast<std::byte>(offset >> 8));
+        if (matchCode >= 15)
+        {
+            putLength(out, matchCode - 15);
+        }
+    }
+}
+
+std::vector<std::byte> lz4::compress(const std::span<const std::byte> input)
+{
+    const std::byte* in = input.data();
+    const size_t size = input.size();
+    std::vector<std::byte> out;
+    out.reserve(size / 2 + 16);
+
+    size_t anchor = 0;
+    if (size > MATCH_LIMIT)
+    {
+        // last position each 4 byte sequence was seen at
+        std::array<int64_t, 1 << HASH_BITS> table;
+        table.fill(-1);
+        for (size_t i = 0; i < size - MATCH_LIMIT;)
+        {
+            const uint32_t sequence = read32(in + i);
+            const int64_t candidate = std::exchange(table[hash(sequence)], i);
+            if (candidate < 0 || i - candidate > MAX_OFFSET || read32(in + candidate) != sequence)
+            {
+                ++i;
+                continue;
+            }
+            size_t length = MIN_MATCH;
+            while (i + length < size - LAST_LITERALS && in[candidate + length] == in[i + length])
+            {
+                ++length;
+            }
+            putSequence(out, in + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+    }
+    putSequence(out, in + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool lz4::decompress(const std::span<const std::byte> input, const std::span<std::byte> output)
+{
+    const std::byte* in = input.data();
+    const std::byte* const inEnd = in + input.size();
+    std::byte* out = output.data();
+    std::byte* const outEnd = out + output.size();
+
+    // false if the length runs past the input
+    const auto readLength = [&in, inEnd](size_t& length)
+    {
+        if (length < 15)
+        {
+            return true;
+        }
+        for (uint8_t b = 255; b == 255; length += b)
+        {
+            if (in == inEnd)
+            {
+                return false;
+            }
+            b = static_cast<uint8_t>(*in++);
+        }
+        return true;
+    };
+
+    while (in < inEnd)
+    {
+        const auto token = static_cast<uint8_t>(*in++);
+        size_t literals = token >> 4;
+        if (!readLength(literals) || literals > static_cast<size_t>(inEnd - in) ||
+            literals > static_cast<size_t>(outEnd - out))
+        {
+            return false;
+        }
+        if (literals <= FAST_COPY && static_cast<size_t>(inEnd - in) >= FAST_COPY &&
+            static_cast<size_t>(outEnd - out) >= FAST_COPY)
+        {
+            std::memcpy(out, in, FAST_COPY);
+        }
+        else if (literals > 0)
+        {
+            std::memcpy(out, in, literals);
+        }
+        in += literals;
+        out += literals;
+        if (in == inEnd)
+        {
+            break;
+        }
+
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+        const size_t offset = static_cast<uint8_t>(in[0]) | static_cast<uint8_t>(in[1]) << 8;
+        in += 2;
+        size_t length = token & 15;
+        if (offset == 0 || offset > static_cast<size_t>(out - output.data()) ||
+            !readLength(length))
+        {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (length > static_cast<size_t>(outEnd - out))
+        {
+            return false;
+        }
+        if (offset >= FAST_COPY && length <= FAST_COPY &&
+            static_cast<size_t>(outEnd - out) >= FAST_COPY)
+        {
+            std::memcpy(out, out - offset, FAST_COPY);
+            out += length;
+            continue;
+        }
+        // a match closer than its length repeats itself, copied a period at a time
+        for (; length > offset; length -= offset)
+        {
+            std::memcpy(out, out - offset, offset);
+            out += offset;
+        }
+        std::memcpy(out, out - offset, length);
+        out += length;
+    }
+    return out == outEnd;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// The LZ4 block format, enough to pack assets and read them back. The compressor is a plain
+// greedy one: it gets most of what LZ4 gets on text like TMX and is fast enough for a build step.
+namespace lz4
+{
+    std::vector<std::byte> compress(std::span<const std::byte> input);
+    // output must be exactly the size of the original, false if input is corrupt
+    bool decompress(std::span<const std::byte> input, std::span<std::byte> output);
+}
@@ -1,18 +1,22 @@
 #include <algorithm>
-#include <array>
-#include <filesystem>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <print>
 #include <string>
-#include <vector>
+#include <string_view>
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
-#include <SDL3_image/SDL_image.h>
 #include <SDL3_mixer/SDL_mixer.h>
 #include <autorelease/AutoRelease.hpp>
 
-#include "gameobject.hpp"
-#include "tmx.hpp"
+#include "game.hpp"
+#include "netplay.hpp"
+#include "pack.hpp"
+#include "snapshot.hpp"
+#include "watcher.hpp"
 
 template<>
 struct std::formatter<SDL_FRect>
@@ -42,290 +46,26 @@ struct std::formatter<glm::vec2>
     }
 };
 
-typedef struct SDLState
-{
-    AutoRelease<bool> sdl_init;
-    AutoRelease<SDL_Window*> window;
-    AutoRelease<SDL_Renderer*> renderer;
-    AutoRelease<bool> mix_init;
-    AutoRelease<MIX_Mixer*> mixer;
-    int width{}, height{};
-    int logW{}, logH{}; // logical width/height
-    const bool* keys{};
-    uint64_t prevTime{};
-    bool fullscreen{};
-
-    ~SDLState() = default;
-} SDLState;
-
-struct GameState
-{
-    std::vector<std::vector<GameObject>> layers{};
-    std::vector<GameObject> bullets{};
-    int playerLayer{};
-
-    int playerIndex = -1;
-    SDL_FRect mapViewport{};
-    float bg2Scroll{}, bg3Scroll{}, bg4Scroll{};
-    bool debugMode{};
-
-    GameState() : GameState(640, 480, 480)
-    {
-    }
-
-    explicit GameState(const float viewPortWidth, const float viewPortHeight, const float mapHeight)
-    {
-        mapViewport = {0, mapHeight - viewPortHeight, viewPortWidth, viewPortHeight};
-    }
-
-    GameObject& player()
-    {
-        return layers[playerLayer][playerIndex];
-    }
-};
-
-struct Sound
-{
-    AutoRelease<MIX_Audio*> audio{};
-    AutoRelease<MIX_Track*> track{};
-    AutoRelease<SDL_PropertiesID> options{};
-
-    Sound(MIX_Mixer* mixer, const std::string& filepath, const int loops)
-    {
-        audio = {MIX_LoadAudio(mixer, filepath.c_str(), false), MIX_DestroyAudio};
-        if (!audio)
-        {
-            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
-            throw std::runtime_error("Error");
-        }
-        track = {MIX_CreateTrack(mixer), MIX_DestroyTrack};
-        if (!track)
-        {
-            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
-            throw std::runtime_error("Error");
-        }
-        if (!MIX_SetTrackAudio(track, audio))
-        {
-            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
-            throw std::runtime_error("Error");
-        }
-
-        options = {SDL_CreateProperties(), SDL_DestroyProperties};
-        if (!options)
-        {
-            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), nullptr);
-            throw std::runtime_error("Error");
-        }
-        SDL_SetNumberProperty(options, MIX_PROP_PLAY_LOOPS_NUMBER, loops);
-    }
-
-    bool play() const
-    {
-        return MIX_PlayTrack(track, options);
-    }
-
-    bool setGain(const float gain) const
-    {
-        return MIX_SetTrackGain(track, gain);
-    }
-};
-
-struct TileSetTextures
-{
-    int firstgid{};
-    std::vector<SDL_Texture*> textures{};
-};
-
-struct Resources
-{
-    // player
-    const int ANIM_PLAYER_IDLE = 0;
-    const int ANIM_PLAYER_RUNNING = 1;
-    const int ANIM_PLAYER_SLIDE = 2;
-    const int ANIM_PLAYER_SHOOT = 3;
-    const int ANIM_PLAYER_SLIDE_SHOOT = 4;
-    std::vector<Animation> playerAnims;
-
-    // bullet
-    const int ANIM_BULLET_MOVING = 0;
-    const int ANIM_BULLET_HIT = 1;
-    std::vector<Animation> bulletAnims;
-
-    // enemy
-    const int ANIM_ENEMY = 0;
-    const int ANIM_ENEMY_HIT = 1;
-    const int ANIM_ENEMY_DIE = 2;
-    std::vector<Animation> enemyAnims;
-
-    std::vector<AutoRelease<SDL_Texture*>> textures;
-
-    // player
-    SDL_Texture* texIdle{};
-    SDL_Texture* texRun{};
-    SDL_Texture* texSlide{};
-    // player shooting
-    SDL_Texture* texShoot{}; // idle
-    SDL_Texture* texRunShoot{};
-    SDL_Texture* texSlideShoot{};
-
-    // tiles
-    SDL_Texture* texBrick{};
-    SDL_Texture* texGrass{};
-    SDL_Texture* texGround{};
-    SDL_Texture* texPanel{};
-
-    // backgrounds
-    SDL_Texture* texBg1{};
-    SDL_Texture* texBg2{};
-    SDL_Texture* texBg3{};
-    SDL_Texture* texBg4{};
-
-    // bullets
-    SDL_Texture* texBullet{};
-    SDL_Texture* texBulletHit{};
-
-    // enemy
-    SDL_Texture* texEnemy{};
-    SDL_Texture* texEnemyHit{};
-    SDL_Texture* texEnemyDie{};
-
-    // Audio
-    std::vector<Sound> sounds{};
-
-    typedef size_t Sound_ID;
-
-    Sound_ID music{};
-    Sound_ID enemy_hit{};
-    Sound_ID enemy_die{};
-    Sound_ID shoot{};
-
-    // Tiled map
-    std::unique_ptr<tmx::Map> map{};
-    std::vector<TileSetTextures> tileSetTextures{};
-
-    SDL_Texture* loadTexture(SDL_Renderer* renderer, const std::string& filepath)
-    {
-        AutoRelease<SDL_Texture*> tex = {IMG_LoadTexture(renderer, filepath.c_str()),
-                                         SDL_DestroyTexture};
-        if (tex == nullptr)
-        {
-            throw std::runtime_error("Failed to load " + std::string(filepath));
-        }
-        SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
-        textures.push_back(std::move(tex));
-        return textures.back();
-    }
-
-    Sound_ID loadAudio(MIX_Mixer* mixer, const std::string& filepath, int loops)
-    {
-        sounds.emplace_back(mixer, filepath, loops);
-        return sounds.size() - 1;
-    }
-
-    void load(const SDLState* state)
-    {
-        playerAnims.resize(5);
-        playerAnims[ANIM_PLAYER_IDLE] = Animation{8, 1.6f};
-        playerAnims[ANIM_PLAYER_RUNNING] = Animation{4, 0.5f};
-        playerAnims[ANIM_PLAYER_SLIDE] = Animation{1, 1.0f};
-        playerAnims[ANIM_PLAYER_SHOOT] = Animation{4, 0.5f};
-        playerAnims[ANIM_PLAYER_SLIDE_SHOOT] = Animation{4, 0.5f};
-
-        bulletAnims.resize(2);
-        bulletAnims[ANIM_BULLET_MOVING] = Animation{4, 0.05f};
-        bulletAnims[ANIM_BULLET_HIT] = Animation{4, 0.15f};
-
-        enemyAnims.resize(3);
-        enemyAnims[ANIM_ENEMY] = Animation{8, 1.0f};
-        enemyAnims[ANIM_ENEMY_HIT] = Animation{8, 1.0f};
-        enemyAnims[ANIM_ENEMY_DIE] = Animation{18, 2.0f};
-
-        texIdle = loadTexture(state->renderer, "data/idle.png");
-        texRun = loadTexture(state->renderer, "data/run.png");
-        texSlide = loadTexture(state->renderer, "data/slide.png");
-        texShoot = loadTexture(state->renderer, "data/shoot.png");
-        texRunShoot = loadTexture(state->renderer, "data/shoot_run.png");
-        texSlideShoot = loadTexture(state->renderer, "data/slide_shoot.png");
-        texBrick = loadTexture(state->renderer, "data/tiles/brick.png");
-        texGrass = loadTexture(state->renderer, "data/tiles/grass.png");
-        texGround = loadTexture(state->renderer, "data/tiles/ground.png");
-        texPanel = loadTexture(state->renderer, "data/tiles/panel.png");
-        texBg1 = loadTexture(state->renderer, "data/bg/bg_layer1.png");
-        texBg2 = loadTexture(state->renderer, "data/bg/bg_layer2.png");
-        texBg3 = loadTexture(state->renderer, "data/bg/bg_layer3.png");
-        texBg4 = loadTexture(state->renderer, "data/bg/bg_layer4.png");
-        texBullet = loadTexture(state->renderer, "data/bullet.png");
-        texBulletHit = loadTexture(state->renderer, "data/bullet_hit.png");
-        texEnemy = loadTexture(state->renderer, "data/enemy.png");
-        texEnemyHit = loadTexture(state->renderer, "data/enemy_hit.png");
-        texEnemyDie = loadTexture(state->renderer, "data/enemy_die.png");
-
-        sounds.reserve(4);
-        music = loadAudio(
-                state->mixer, "data/audio/Juhani Junkala [Retro Game Music Pack] Level 1.mp3", -1);
-        enemy_hit = loadAudio(state->mixer, "data/audio/enemy_hit.wav", 0);
-        enemy_die = loadAudio(state->mixer, "data/audio/monster_die.wav", 0);
-        shoot = loadAudio(state->mixer, "data/audio/shoot.wav", 0);
-
-        // map = tmx::loadMap("data/maps/smallmap.tmx");
-        // map = tmx::loadMap("data/maps/bigmap.tmx");
-        map = tmx::loadMap("data/maps/original.tmx");
-        if (!map)
-        {
-            throw std::runtime_error("Error loading map.");
-        }
-        for (tmx::TileSet& tileSet: map->tileSets)
-        {
-            TileSetTextures tst;
-            tst.firstgid = tileSet.firstgid;
-            tst.textures.reserve(tileSet.tiles.size());
-
-            for (const auto& [id, image]: tileSet.tiles)
-            {
-                const std::string imagePath =
-                        "data/tiles/" + std::filesystem::path(image.source).filename().
-                        string();
-                tst.textures.push_back(loadTexture(state->renderer, imagePath));
-            }
-
-            tileSetTextures.push_back(std::move(tst));
-        }
-    }
-
-    bool playSound(const Sound_ID sound_id) const
-    {
-        return sounds.at(sound_id).play();
-    }
-
-    bool setSoundGain(const Sound_ID sound_id, const float gain) const
-    {
-        return sounds.at(sound_id).setGain(gain);
-    }
-
-    ~Resources() = default;
-};
-
 typedef struct AppState
 {
     SDLState sdlState{};
     GameState gameState{};
     Resources resources{};
+    FileWatcher watcher{};
+    // five seconds of play at 60 FPS, replayed backwards while backspace is held
+    SnapshotRing rewind{300};
+    // set when two copies of the game play together, see SDL_AppInit
+    std::unique_ptr<RollbackSession> netplay{};
+    float netplayLag{}; // seconds of wall clock not simulated yet
 } AppState;
 
-void drawObject(
-        const SDLState* state, const GameState* gs, GameObject& obj, float width, float height,
-        float deltaTime);
-void update(
-        const SDLState* state, GameState* gs, const Resources* res, GameObject& obj,
-        float deltaTime);
-void createTiles(const SDLState* state, GameState* gs, const Resources* res);
-void checkCollision(const Resources* res, GameObject& objA, GameObject& objB, bool isHorizontal);
-void collisionResponse(
-        const Resources* res, const SDL_FRect& rectB, GameObject& a, GameObject& b,
-        bool isHorizontal);
-void drawParallaxBackground(
-        SDL_Renderer* renderer, SDL_Texture* texture, float xVelocity, float& scrollPos,
-        float scrollFactor, float deltaTime);
+// netplay ticks simulated in one frame at most, to catch up after a long one
+constexpr int MAX_TICKS_PER_FRAME = 4;
+
+template<typename... Args>
+void drawDebugText(
+        SDLState* state, float x, float y, std::format_string<Args...> fmt, Args&&... args);
+std::string quickSavePath();
 
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
 {
@@ -405,9 +145,67 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
         return SDL_APP_FAILURE;
     }
 
-    res->load(ss);
-    res->setSoundGain(res->music, 0.333f);
-    if (!res->playSound(res->music))
+    // sdl3-demo [map.tmx] [--netplay=<player>:<local port>:<remote port>]
+    //           [--resolution=<min scale>:<max scale>]
+    // the map can be e.g. data/maps/bigmap.tmx or one made by sdl3-demo-mapgen.
+    // With --netplay two copies of the game on this machine play together as player 0 and 1,
+    // e.g. --netplay=0:7000:7001 and --netplay=1:7001:7000
+    // --resolution bounds the size the game is drawn at, in multiples of 640x320, e.g. 1:1
+    // draws every frame at 640x320. By default it goes from half that up to the window's size.
+    std::string mapPath = "data/maps/original.tmx";
+    float minScale = 0.5f, maxScale = std::numeric_limits<float>::max();
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--resolution="))
+        {
+            if (std::sscanf(argv[i] + arg.find('=') + 1, "%f:%f", &minScale, &maxScale) != 2 ||
+                minScale <= 0 || maxScale < minScale)
+            {
+                SDL_ShowSimpleMessageBox(
+                        SDL_MESSAGEBOX_ERROR, "Error", "Expected --resolution=<min>:<max>",
+                        ss->window);
+                return SDL_APP_FAILURE;
+            }
+            continue;
+        }
+        if (!arg.starts_with("--netplay="))
+        {
+            mapPath = arg;
+            continue;
+        }
+        int player;
+        unsigned localPort, remotePort;
+        if (std::sscanf(argv[i] + arg.find('=') + 1, "%d:%u:%u", &player, &localPort,
+                        &remotePort) != 3 || (player != 0 && player != 1))
+        {
+            SDL_ShowSimpleMessageBox(
+                    SDL_MESSAGEBOX_ERROR, "Error", "Expected --netplay=<0|1>:<port>:<port>",
+                    ss->window);
+            return SDL_APP_FAILURE;
+        }
+        as->netplay = std::make_unique<RollbackSession>(player, 1 - player);
+        if (!as->netplay->open(localPort) || !as->netplay->setPeer("127.0.0.1", remotePort))
+        {
+            SDL_ShowSimpleMessageBox(
+                    SDL_MESSAGEBOX_ERROR, "Error", "Failed to open the netplay socket",
+                    ss->window);
+            return SDL_APP_FAILURE;
+        }
+    }
+    // three quarters of a refresh to draw a frame in, the rest is for the simulation
+    const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(ss->window));
+    const float refreshRate = mode && mode->refresh_rate > 0 ? mode->refresh_rate : 60.0f;
+    ss->resolution.init(ss->renderer, ss->logW, ss->logH, minScale, maxScale, 750 / refreshRate);
+
+    // one mapped file instead of a file per asset when the pack was built, see pack_data
+    const bool packed = assets::mount(assets::DEFAULT_PACK);
+    const uint64_t loadStart = SDL_GetPerformanceCounter();
+    res->load(ss, mapPath);
+    SDL_Log("Loaded %s from %s in %.1f ms", mapPath.c_str(),
+            packed ? assets::DEFAULT_PACK : "data/",
+            (SDL_GetPerformanceCounter() - loadStart) * 1000.0 / SDL_GetPerformanceFrequency());
+    if (!res->audio.playMusic(res->music, 0.333f))
     {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", SDL_GetError(), ss->window);
         return SDL_APP_FAILURE;
@@ -416,6 +214,26 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
     auto* gs = &as->gameState;
     *gs = GameState(ss->logW, ss->logH, res->map->mapHeight * res->map->tileHeight);
     createTiles(ss, gs, res);
+    if (as->netplay)
+    {
+        addPlayers(gs, res, 2);
+    }
+
+    // maps, tilesets and textures saved while the game runs are picked up on the next frame.
+    // The pack would still hand out the old files.
+    if (packed)
+    {
+        SDL_Log("Hot reload is off, assets come from %s", assets::DEFAULT_PACK);
+    }
+    else if (as->netplay)
+    {
+        // a reload on one end only would desync the peers, both must play the same level
+        SDL_Log("Hot reload is off during netplay");
+    }
+    else if (!as->watcher.watch("data"))
+    {
+        SDL_Log("Hot reload is off, data can't be watched");
+    }
 
     // force double buffer allocate memory
     SDL_SetRenderDrawColor(ss->renderer, 0, 0, 0, 255);
@@ -433,6 +251,8 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
 {
     auto* ss = &((AppState*)appstate)->sdlState;
     auto* gs = &((AppState*)appstate)->gameState;
+    auto* res = &((AppState*)appstate)->resources;
+    const auto* netplay = ((AppState*)appstate)->netplay.get();
 
     switch (event->type)
     {
@@ -457,6 +277,28 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
                 ss->fullscreen = !ss->fullscreen;
                 SDL_SetWindowFullscreen(ss->window, ss->fullscreen);
             }
+            if (event->key.scancode == SDL_SCANCODE_F5)
+            {
+                Snapshot snapshot;
+                snapshot.capture(*gs, *res);
+                if (!snapshot.save(quickSavePath()))
+                {
+                    SDL_Log("Quick save failed: %s", SDL_GetError());
+                }
+            }
+            // loading only here would desync the peers for good, like rewinding would
+            if (event->key.scancode == SDL_SCANCODE_F9 && netplay)
+            {
+                SDL_Log("Quick load is off during netplay");
+            }
+            else if (event->key.scancode == SDL_SCANCODE_F9)
+            {
+                Snapshot snapshot;
+                if (!snapshot.load(quickSavePath()) || !snapshot.restore(*gs, *res))
+                {
+                    SDL_Log("No quick save for this map");
+                }
+            }
             break;
         }
         default:
@@ -472,95 +314,128 @@ SDL_AppResult SDL_AppIterate(void* appstate)
 {
     auto* ss = &((AppState*)appstate)->sdlState;
     auto* gs = &((AppState*)appstate)->gameState;
-    const auto* res = &((AppState*)appstate)->resources;
+    auto* res = &((AppState*)appstate)->resources;
+    auto* watcher = &((AppState*)appstate)->watcher;
+    auto* rewind = &((AppState*)appstate)->rewind;
+    auto* netplay = ((AppState*)appstate)->netplay.get();
+    auto* netplayLag = &((AppState*)appstate)->netplayLag;
 
     const uint64_t nowTime = SDL_GetTicks();
     const float deltaTime = (float)(nowTime - ss->prevTime) / 1000.0f;
     ss->prevTime = nowTime;
 
-    // calculate viewport position
-    gs->mapViewport.x = gs->player().position.x + res->map->tileWidth / 2.0f - gs->mapViewport.w /
-                        2.0f;
-
-    // Draw
-    SDL_SetRenderDrawColor(ss->renderer, 20, 10, 30, 255);
-    SDL_RenderClear(ss->renderer);
-
-    SDL_RenderTexture(ss->renderer, res->texBg1, nullptr, nullptr);
-    drawParallaxBackground(
-            ss->renderer, res->texBg4, gs->player().velocity.x, gs->bg4Scroll, 0.075f, deltaTime);
-    drawParallaxBackground(
-            ss->renderer, res->texBg3, gs->player().velocity.x, gs->bg3Scroll, 0.150f, deltaTime);
-    drawParallaxBackground(
-            ss->renderer, res->texBg2, gs->player().velocity.x, gs->bg2Scroll, 0.3f, deltaTime);
+    // everything allocated from the arena last frame is gone now
+    ss->frameArena.reset();
+    const size_t allocations = memory::allocationCount();
+    ss->frameAllocations = allocations - ss->allocationMark;
+    ss->allocationMark = allocations;
 
-    // update
-    for (auto& layer: gs->layers)
+    for (const std::string& path: watcher->poll())
     {
-        for (auto& obj: layer)
+        const uint64_t reloadStart = SDL_GetPerformanceCounter();
+        if (reloadAsset(ss, gs, res, path))
         {
-            if (obj.dynamic)
-            {
-                update(ss, gs, res, obj, deltaTime);
-            }
+            ss->reloadMs = (SDL_GetPerformanceCounter() - reloadStart) * 1000.0f /
+                           SDL_GetPerformanceFrequency();
+            ss->reloadedPath = path;
+            SDL_Log("Reloaded %s in %.1f ms", path.c_str(), ss->reloadMs);
         }
     }
 
-    for (auto& bullet: gs->bullets)
-    {
-        update(ss, gs, res, bullet, deltaTime);
-    }
-
-
-    // draw
-    for (auto& layer: gs->layers)
+    if (netplay)
     {
-        for (auto& obj: layer)
+        // fixed ticks with the inputs of both ends, the viewport is set by the session.
+        // As many as fit in the time that passed, so the game runs at the same speed on both
+        // ends whatever their refresh rate, and what is left over goes to the next frame.
+        // After a long frame or while waiting for the peer it catches up a few ticks at most.
+        constexpr float tickTime = RollbackSession::TICK_TIME;
+        *netplayLag = std::min(*netplayLag + deltaTime, MAX_TICKS_PER_FRAME * tickTime);
+        const PlayerInput input = readKeyboard(ss->keys);
+        while (*netplayLag >= tickTime && netplay->advance(ss, gs, res, input, nowTime))
         {
-            drawObject(ss, gs, obj, res->map->tileWidth, res->map->tileHeight, deltaTime);
+            *netplayLag -= tickTime;
         }
     }
-
-    for (auto& bullet: gs->bullets)
+    else if (ss->keys[SDL_SCANCODE_BACKSPACE] && rewind->size() > 0)
     {
-        if (bullet.data.bullet.state != BulletState::inactive)
+        // snapshots from before a map reload don't fit anymore and are dropped
+        if (!rewind->get(0)->restore(*gs, *res))
         {
-            drawObject(ss, gs, bullet, bullet.collider.w, bullet.collider.h, deltaTime);
+            rewind->pop(rewind->size());
         }
+        rewind->pop();
     }
+    else
+    {
+        // every player in the map is driven by the keyboard
+        gs->inputs.fill(readKeyboard(ss->keys));
+        updateViewport(gs, res);
+        updateGame(ss, gs, res, deltaTime);
+        rewind->push().capture(*gs, *res);
+    }
+    // on the wall clock, tiles and particles keep animating while the game rewinds or waits
+    // for the peer. Bursts queued by this frame's ticks start moving next frame.
+    res->tileAnimations.update(deltaTime);
+    gs->particles.update(deltaTime);
+    gs->particles.process(res->emitters, gs->particleEvents);
+    ss->resolution.begin();
+    drawGame(ss, gs, res, deltaTime);
+    // scaled up to the window; the overlay is drawn on top, still in the window's logical
+    // coordinates but not through the texture, so it keeps its size at any resolution
+    ss->resolution.end();
 
     if (gs->debugMode)
     {
         SDL_SetRenderDrawColor(ss->renderer, 255, 255, 255, 255);
-        SDL_RenderDebugText(
-                ss->renderer, 5, 5,
-                std::format(
-                        "S: {} B: {} G: {} D: {} dt: {} FPS: {}",
-                        static_cast<int>(gs->player().data.player.state),
-                        gs->bullets.size(),
-                        gs->player().grounded,
-                        gs->player().direction,
-                        deltaTime,
-                        1.0f / deltaTime
-                        ).c_str()
-                );
-
-        SDL_RenderDebugText(
-                ss->renderer, 5, 15,
-                std::format("Rect: {}", gs->player().GetCollider()).c_str()
-                );
-        SDL_RenderDebugText(
-                ss->renderer, 5, 25,
-                std::format("Vel: {}", gs->player().velocity).c_str()
-                );
-        SDL_RenderDebugText(
-                ss->renderer, 5, 35,
-                std::format("View: {}", gs->mapViewport).c_str()
-                );
+        drawDebugText(
+                ss, 5, 5, "S: {} B: {} G: {} D: {} dt: {} FPS: {}",
+                static_cast<int>(gs->player().get<PlayerData>().state), gs->bullets.size(),
+                gs->player().grounded, gs->player().direction, deltaTime, 1.0f / deltaTime);
+        drawDebugText(ss, 5, 15, "Rect: {}", gs->player().GetCollider());
+        drawDebugText(ss, 5, 25, "Vel: {}", gs->player().velocity);
+        drawDebugText(ss, 5, 35, "View: {}", gs->mapViewport);
+        drawDebugText(
+                ss, 5, 45, "Awake: {}/{} Flow: {:.3f} ms Rect tests: {} Rescans: {}",
+                gs->awakeEnemies, gs->enemyCount, gs->flowFieldMs, gs->collisionTests,
+                gs->contactScans);
+        drawDebugText(
+                ss, 5, 55, "Sprites: {} Opaque: {} Batches: {} Draw calls: {}",
+                ss->batchStats.sprites, ss->batchStats.opaque, ss->batchStats.batches,
+                ss->batchStats.drawCalls);
+        drawDebugText(
+                ss, 5, 65, "Allocs/frame: {} Particles: {} Events: {}", ss->frameAllocations,
+                gs->particles.getStats().particles, gs->eventCount);
+        const AudioSystem::Stats& audio = res->audio.getStats();
+        drawDebugText(
+                ss, 5, 75, "Sounds: {} culled {} over budget {} started {} mixer {:.3f} ms",
+                audio.requested, audio.culled, audio.overBudget, audio.started, audio.mixerMs);
+        const ResolutionScaler::Stats& resolution = ss->resolution.getStats();
+        drawDebugText(
+                ss, 5, 85, "Resolution: {}x{} ({:.3f}x) Draw: {:.2f} ms", resolution.width,
+                resolution.height, resolution.scale, resolution.drawMs);
+        if (!ss->reloadedPath.empty())
+        {
+            drawDebugText(ss, 5, 95, "Reload: {} {:.1f} ms", ss->reloadedPath, ss->reloadMs);
+        }
+        drawDebugText(
+                ss, 5, 105, "Rewind: {} ticks Snapshot: {} B", rewind->size(),
+                rewind->size() > 0 ? rewind->get(0)->size() : 0);
+        if (netplay)
+        {
+            const RollbackSession::Stats& net = netplay->getStats();
+            drawDebugText(
+                    ss, 5, 115, "Net: tick {} confirmed {} rollbacks {} stalls {}", net.frame,
+                    net.confirmedFrame, net.rollbacks, net.stalls);
+            drawDebugText(
+                    ss, 5, 125, "Last rollback: {} ticks {:.2f} ms (max {:.2f} ms)",
+                    net.lastResimulated, net.lastRollbackMs, net.maxRollbackMs);
+        }
     }
 
     SDL_RenderPresent(ss->renderer);
 
+    res->audio.process(gs->soundEvents, gs->mapViewport);
+
     return SDL_APP_CONTINUE;
 }
 
@@ -571,658 +446,26 @@ void SDL_AppQuit(void* appstate, SDL_AppResult result)
     SDL_free(as);
 }
 
-void drawObject(
-        const SDLState* state, const GameState* gs, GameObject& obj, const float width,
-        const float height,
-        const float deltaTime)
-{
-    SDL_FRect src{.x = 0, .y = 0, .w = width, .h = height};
-
-    // if currentAnimation == -1, draw the specific frame index spriteFrame
-    src.x = obj.currentAnimation >= 0
-                ? obj.animations[obj.currentAnimation].currentFrame() * width
-                : (obj.spriteFrame - 1) * width;
-
-    const SDL_FRect dst{
-            .x = obj.position.x - gs->mapViewport.x, .y = obj.position.y - gs->mapViewport.y,
-            .w = width, .h = height
-    };
-
-    const SDL_FlipMode flipMode = obj.direction < 0 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-
-    if (!obj.shouldFlash)
-    {
-        SDL_RenderTextureRotated(
-                state->renderer, obj.texture, &src, &dst, 0, nullptr,
-                flipMode);
-    }
-    else
-    {
-        // flash object with a red-ish tint
-        SDL_SetTextureColorModFloat(obj.texture, 2.5f, 1.0f, 1.0f);
-        SDL_RenderTextureRotated(
-                state->renderer, obj.texture, &src, &dst, 0, nullptr,
-                flipMode);
-        SDL_SetTextureColorModFloat(obj.texture, 1.5f, 1.0f, 1.0f);
-
-        // check if timer has finished
-        if (obj.flashTimer.step(deltaTime))
-        {
-            obj.shouldFlash = false;
-        }
-    }
-
-    if (gs->debugMode)
-    {
-        SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_BLEND);
-
-        // collision
-        const SDL_FRect rectA = {
-                obj.position.x + obj.collider.x - gs->mapViewport.x,
-                obj.position.y + obj.collider.y - gs->mapViewport.y,
-                obj.collider.w,
-                obj.collider.h,
-        };
-        SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 150);
-        SDL_RenderFillRect(state->renderer, &rectA);
-
-        // ground sensor
-        const SDL_FRect ground_sensor{
-                .x = obj.position.x + obj.collider.x - gs->mapViewport.x,
-                .y = obj.position.y + obj.collider.y + obj.collider.h - gs->mapViewport.y,
-                .w = obj.collider.w, .h = 1
-        };
-        SDL_SetRenderDrawColor(state->renderer, 0, 0, 255, 150);
-        SDL_RenderFillRect(state->renderer, &ground_sensor);
-
-        SDL_SetRenderDrawBlendMode(state->renderer, SDL_BLENDMODE_NONE);
-    }
-}
-
-void update(
-        const SDLState* state, GameState* gs, const Resources* res, GameObject& obj,
-        const float deltaTime)
-{
-    if (obj.currentAnimation >= 0)
-    {
-        obj.animations[obj.currentAnimation].step(deltaTime);
-    }
-
-    // apply some gravity
-    if (obj.dynamic)
-    {
-        obj.velocity += glm::vec2(0, 500) * deltaTime;
-    }
-
-    float currentDirection = 0;
-    if (obj.type == ObjectType::player)
-    {
-        if (state->keys[SDL_SCANCODE_A])
-        {
-            currentDirection += -1;
-        }
-        if (state->keys[SDL_SCANCODE_D])
-        {
-            currentDirection += 1;
-        }
-
-        const auto handleJump = [&]()
-        {
-            if (state->keys[SDL_SCANCODE_K] && obj.grounded)
-            {
-                constexpr float JUMP_FORCE = -200.0f;
-                obj.velocity.y += JUMP_FORCE;
-                obj.data.player.state = PlayerState::jumping;
-                obj.grounded = false;
-            }
-        };
-
-        Timer& weaponTimer = obj.data.player.weaponTimer;
-        weaponTimer.step(deltaTime);
-        const auto handleShooting = [&](
-                SDL_Texture* tex, SDL_Texture* shootTex, const int animIndex,
-                const int shootAnimIndex)
-        {
-            if (state->keys[SDL_SCANCODE_J])
-            {
-                // set shooting tex/anim
-                obj.texture = shootTex;
-                obj.currentAnimation = shootAnimIndex;
-
-                if (weaponTimer.isTimeout())
-                {
-                    weaponTimer.reset();
-                    GameObject bullet;
-                    bullet.type = ObjectType::bullet;
-                    bullet.data.bullet = BulletData();
-                    bullet.direction = gs->player().direction;
-                    bullet.texture = res->texBullet;
-                    bullet.currentAnimation = res->ANIM_BULLET_MOVING;
-                    bullet.collider = {
-                            0, 0, static_cast<float>(res->texBullet->h),
-                            static_cast<float>(res->texBullet->h)
-                    };
-                    // bullets have random Y velocity
-                    constexpr Sint32 yVariation = 40.f;
-                    const Sint32 yVel = SDL_rand(yVariation) - yVariation / 2;
-                    bullet.velocity = glm::vec2(obj.velocity.x + 600.0f * obj.direction, yVel);
-                    bullet.animations = res->bulletAnims;
-                    bullet.maxSpeedX = 1000.0f;
-
-                    // adjust bullet position (lerp)
-                    constexpr float left = 0;
-                    const float right = res->map->tileWidth - bullet.collider.w;
-                    const float t = (obj.direction + 1) / 2.0f; // 0 to 1
-                    const float xOffset = left + right * t;
-                    bullet.position = glm::vec2(
-                            obj.position.x + xOffset,
-                            obj.position.y + res->map->tileHeight / 2.0f + 1);
-
-                    // reuse inactive slots
-                    bool foundInactive = false;
-                    for (auto& bullet_obj: gs->bullets)
-                    {
-                        if (bullet_obj.data.bullet.state == BulletState::inactive)
-                        {
-                            foundInactive = true;
-                            bullet_obj = std::move(bullet);
-                            break;
-                        }
-                    }
-                    // if no inactive, push as new one
-                    if (!foundInactive)
-                    {
-                        gs->bullets.push_back(std::move(bullet));
-                    }
-                    res->playSound(res->shoot);
-                }
-            }
-            else
-            {
-                obj.texture = tex;
-                obj.currentAnimation = animIndex;
-            }
-        };
-
-        switch (obj.data.player.state)
-        {
-            case PlayerState::idle:
-            {
-                if (currentDirection != 0)
-                {
-                    obj.data.player.state = PlayerState::running;
-                }
-                else
-                {
-                    // deacceleration
-                    if (obj.velocity.x != 0)
-                    {
-                        const float factor = obj.velocity.x > 0 ? -1.5f : 1.5f;
-                        const float amount = factor * obj.acceleration.x * deltaTime;
-                        if (std::abs(obj.velocity.x) < std::abs(amount))
-                        {
-                            obj.velocity.x = 0;
-                        }
-                        else
-                        {
-                            obj.velocity.x += amount;
-                        }
-                    }
-                }
-                handleJump();
-                handleShooting(
-                        res->texIdle, res->texShoot, res->ANIM_PLAYER_IDLE, res->ANIM_PLAYER_SHOOT);
-                break;
-            }
-            case PlayerState::running:
-            {
-                if (currentDirection == 0)
-                {
-                    obj.data.player.state = PlayerState::idle;
-                }
-                handleJump();
-
-                // moving in opposite direction of velocity, sliding! (changing direction during move)
-                if (obj.velocity.x * obj.direction < 0 && obj.grounded)
-                {
-                    handleShooting(
-                            res->texSlide, res->texSlideShoot, res->ANIM_PLAYER_SLIDE,
-                            res->ANIM_PLAYER_SLIDE_SHOOT);
-                }
-                else
-                {
-                    // when running, use same index. Both texture have the same size, so, the Animation class
-                    // can use the same frameIndex when switching images
-                    handleShooting(
-                            res->texRun, res->texRunShoot, res->ANIM_PLAYER_RUNNING,
-                            res->ANIM_PLAYER_RUNNING);
-                }
-                break;
-            }
-            case PlayerState::jumping:
-            {
-                handleShooting(
-                        res->texRun, res->texRunShoot, res->ANIM_PLAYER_RUNNING,
-                        res->ANIM_PLAYER_RUNNING);
-                if (obj.grounded)
-                {
-                    obj.data.player.state = PlayerState::running;
-                    // if player stopped running, the next frame will change to idle
-                }
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
-    }
-    else if (obj.type == ObjectType::bullet)
-    {
-        switch (obj.data.bullet.state)
-        {
-            case BulletState::moving:
-            {
-                if (obj.position.x - gs->mapViewport.x < 0 ||
-                    obj.position.x - gs->mapViewport.x > state->logW ||
-                    obj.position.y - gs->mapViewport.y < 0 ||
-                    obj.position.y - gs->mapViewport.y > state->logH
-                )
-                {
-                    obj.data.bullet.state = BulletState::inactive;
-                }
-                break;
-            }
-            case BulletState::colliding:
-            {
-                if (obj.animations[obj.currentAnimation].isDone())
-                {
-                    obj.data.bullet.state = BulletState::inactive;
-                }
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
-    }
-    else if (obj.type == ObjectType::enemy)
-    {
-        EnemyData& d = obj.data.enemy;
-        switch (d.state)
-        {
-            case EnemyState::shambling:
-            {
-                const glm::vec2 playerDir = gs->player().position - obj.position;
-                if (glm::length(playerDir) < 100)
-                {
-                    currentDirection = playerDir.x > 0 ? 1 : -1;
-                    obj.acceleration = glm::vec2(30, 0);
-                }
-                else
-                {
-                    obj.acceleration = glm::vec2{0};
-                    obj.velocity.x = 0;
-                }
-                break;
-            }
-            case EnemyState::damaged:
-            {
-                // if damaged timer has finished, go back to shambling
-                if (d.damagedTimer.step(deltaTime))
-                {
-                    d.state = EnemyState::shambling;
-                    obj.texture = res->texEnemy;
-                    obj.currentAnimation = res->ANIM_ENEMY;
-                }
-                break;
-            }
-            case EnemyState::dead:
-            {
-                obj.velocity.x = 0;
-                // when enemy is dead, make it draw only the last frame
-                if (obj.currentAnimation != -1 &&
-                    obj.animations[obj.currentAnimation].isDone())
-                {
-                    obj.currentAnimation = -1;
-                    obj.spriteFrame = 18;
-                }
-                break;
-            }
-        }
-    }
-
-    // an object always need a direction
-    if (currentDirection != 0)
-    {
-        obj.direction = currentDirection;
-    }
-    obj.velocity += currentDirection * obj.acceleration * deltaTime;
-    obj.velocity.x = glm::clamp(obj.velocity.x, -obj.maxSpeedX, obj.maxSpeedX);
-
-    // horizontal
-    obj.position.x += obj.velocity.x * deltaTime;
-    for (auto& layer: gs->layers)
-    {
-        for (auto& objB: layer)
-        {
-            if (&obj == &objB || objB.collider.w == 0 || objB.collider.h == 0)
-            {
-                continue;
-            }
-            checkCollision(res, obj, objB, true);
-        }
-    }
-    // vertical
-    obj.grounded = false;
-    obj.position.y += obj.velocity.y * deltaTime;
-    for (auto& layer: gs->layers)
-    {
-        for (auto& objB: layer)
-        {
-            if (&obj == &objB || objB.collider.w == 0 || objB.collider.h == 0)
-            {
-                continue;
-            }
-            checkCollision(res, obj, objB, false);
-        }
-    }
-}
-
-void collisionResponse(
-        const Resources* res, const SDL_FRect& rectB, GameObject& a, GameObject& b,
-        const bool isHorizontal)
+template<typename... Args>
+void drawDebugText(
+        SDLState* state, const float x, const float y, std::format_string<Args...> fmt,
+        Args&&... args)
 {
-    const auto genericResponse = [&]()
-    {
-        if (isHorizontal) // horizontal collision
-        {
-            if (a.velocity.x > 0) // going right
-            {
-                a.position.x = rectB.x - a.collider.w - a.collider.x;
-                a.velocity.x = 0;
-            }
-            else if (a.velocity.x < 0)
-            {
-                a.position.x = rectB.x + rectB.w - a.collider.x;
-                a.velocity.x = 0;
-            }
-        }
-        else if (!isHorizontal) // vertical
-        {
-            if (a.velocity.y > 0) // going down
-            {
-                a.position.y = rectB.y - a.collider.h - a.collider.y;
-                a.velocity.y = 0;
-                if (b.type == ObjectType::level)
-                {
-                    a.grounded = true;
-                }
-            }
-            else if (a.velocity.y < 0)
-            {
-                a.position.y = rectB.y + rectB.h - a.collider.y;
-                a.velocity.y = 0;
-            }
-        }
-    };
-
-    if (a.type == ObjectType::player)
-    {
-        switch (b.type)
-        {
-            case ObjectType::level:
-            {
-                genericResponse();
-                break;
-            }
-            case ObjectType::enemy:
-            {
-                // bounce player if collides with enemy
-                if (b.data.enemy.state != EnemyState::dead)
-                {
-                    a.velocity = glm::vec2(100, 0) * -a.direction;
-                }
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
-    }
-    else if (a.type == ObjectType::bullet)
-    {
-        switch (a.data.bullet.state)
-        {
-            case BulletState::moving:
-            {
-                const auto bulletResponse = [&]()
-                {
-                    genericResponse();
-                    a.data.bullet.state = BulletState::colliding;
-                    a.texture = res->texBulletHit;
-                    a.currentAnimation = res->ANIM_BULLET_HIT;
-                    // force velocity 0 bullet changes state on vertical and next frame genericResponse()
-                    // is not called for horizontal because of change state
-                    a.velocity *= 0;
-                };
-                switch (b.type)
-                {
-                    case ObjectType::level:
-                    {
-                        bulletResponse();
-                        break;
-                    }
-                    case ObjectType::enemy:
-                    {
-                        EnemyData& d = b.data.enemy;
-                        if (d.state == EnemyState::dead)
-                        {
-                            break;
-                        }
-                        b.direction = -a.direction;
-                        b.shouldFlash = true;
-                        b.flashTimer.reset();
-                        b.texture = res->texEnemyHit;
-                        b.currentAnimation = res->ANIM_ENEMY_HIT;
-                        d.state = EnemyState::damaged;
-                        d.healthPoints -= 10;
-                        if (d.healthPoints <= 0)
-                        {
-                            d.state = EnemyState::dead;
-                            b.texture = res->texEnemyDie;
-                            b.currentAnimation = res->ANIM_ENEMY_DIE;
-                            res->playSound(res->enemy_die);
-                        }
-                        else
-                        {
-                            res->playSound(res->enemy_hit);
-                        }
-                        bulletResponse();
-                        break;
-                    }
-                    default:
-                    {
-                        break;
-                    }
-                }
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
-    }
-    else if (a.type == ObjectType::enemy)
-    {
-        genericResponse();
-        if (b.type == ObjectType::player)
-        {
-            // bounce player if collides with enemy
-            if (a.data.enemy.state != EnemyState::dead)
-            {
-                const int ax = a.position.x + a.collider.x + a.collider.w / 2;
-                const int bx = b.position.x + b.collider.x + b.collider.w / 2;
-                b.velocity = glm::vec2(100, 0) * (ax > bx ? -1.0f : 1.0f);
-            }
-        }
-    }
+    // formatted into the frame arena, the overlay costs no heap allocations
+    std::pmr::string text(state->frameArena.resource());
+    std::format_to(std::back_inserter(text), fmt, std::forward<Args>(args)...);
+    SDL_RenderDebugText(state->renderer, x, y, text.c_str());
 }
 
-void checkCollision(
-        const Resources* res, GameObject& objA, GameObject& objB, const bool isHorizontal)
+std::string quickSavePath()
 {
-    const SDL_FRect rectA = objA.GetCollider();
-    const SDL_FRect rectB = objB.GetCollider();
-    SDL_FRect rectC{}; // collision result
-
-    if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC) && (
-            rectC.w > 0.00001f && rectC.h > 0.00001f))
+    // next to the user's other settings, the game folder may not be writable
+    char* prefPath = SDL_GetPrefPath("brunorcabral", "platformer-shooter");
+    if (prefPath == nullptr)
     {
-        collisionResponse(res, rectB, objA, objB, isHorizontal);
+        return "quicksave.bin";
     }
-}
-
-void createTiles(const SDLState* state, GameState* gs, const Resources* res)
-{
-    struct LayerVisitor
-    {
-        const SDLState* state;
-        GameState* gs;
-        const Resources* res;
-
-        LayerVisitor(const SDLState* state, GameState* gs, const Resources* res) : state(state),
-            gs(gs), res(res)
-        {
-        }
-
-        GameObject createObject(
-                const int r, const int c, SDL_Texture* tex, const ObjectType type) const
-        {
-            GameObject o;
-            o.type = type;
-            o.position = glm::vec2(c * res->map->tileWidth, r * res->map->tileHeight);
-            o.texture = tex;
-            o.collider = {0, 0, static_cast<float>(res->map->tileWidth),
-                          static_cast<float>(res->map->tileHeight)};
-            return o;
-        };
-
-        void operator()(const tmx::Layer& layer) const
-        {
-            std::vector<GameObject> newLayer;
-            for (auto r = 0; r < res->map->mapHeight; ++r)
-            {
-                for (auto c = 0; c < res->map->mapWidth; ++c)
-                {
-                    // tile global ID
-                    const int tGid = layer.data[r * res->map->mapWidth + c];
-                    if (!tGid) // 0 = empty tile
-                    {
-                        continue;
-                    }
-                    // find the texture for that id
-                    const auto itr = std::ranges::find_if(
-                            res->tileSetTextures.begin(), res->tileSetTextures.end(),
-                            [tGid](const TileSetTextures& res_tst)
-                            {
-                                return tGid >= res_tst.firstgid && tGid < res_tst.firstgid
-                                       +
-                                       res_tst.textures.
-                                               size();
-                            }
-                            );
-                    assert(itr != res->tileSetTextures.end());
-                    const auto& [firstgid, textures] = *itr;
-                    SDL_Texture* tex = textures[tGid - firstgid];
-
-                    auto tile = createObject(r, c, tex, ObjectType::level);
-                    if (layer.name != "Level") // foreground/background
-                    {
-                        tile.collider.w = tile.collider.h = 0;
-                    }
-
-                    newLayer.push_back(std::move(tile));
-                }
-            }
-            gs->layers.push_back(std::move(newLayer));
-        }
-
-        void operator()(tmx::ObjectGroup& objectGroup) const
-        {
-            std::vector<GameObject> newLayer;
-            for (tmx::LayerObject& obj: objectGroup.objects)
-            {
-                glm::vec2 objPos(
-                        obj.x - res->map->tileWidth / 2.0f, obj.y - res->map->tileHeight / 2.0f);
-
-                if (obj.type == "player")
-                {
-                    GameObject player = createObject(1, 1, res->texIdle, ObjectType::player);
-                    player.position = objPos;
-                    player.data.player = PlayerData();
-                    player.animations = res->playerAnims;
-                    player.currentAnimation = res->ANIM_PLAYER_IDLE;
-                    player.acceleration = glm::vec2(300.f, 0.f);
-                    player.maxSpeedX = 100.f;
-                    player.dynamic = true;
-                    player.collider = {11, 6, 10, 26};
-
-                    gs->playerIndex = newLayer.size();
-                    newLayer.push_back(std::move(player));
-                    gs->playerLayer = gs->layers.size();
-                }
-                else if (obj.type == "enemy")
-                {
-                    GameObject enemy = createObject(1, 1, res->texEnemy, ObjectType::enemy);
-                    enemy.position = objPos;
-                    enemy.data.enemy = EnemyData();
-                    enemy.currentAnimation = res->ANIM_ENEMY;
-                    enemy.animations = res->enemyAnims;
-                    enemy.collider = {10, 4, 12, 28};
-                    enemy.dynamic = true;
-                    enemy.maxSpeedX = 15;
-
-                    newLayer.push_back(std::move(enemy));
-                }
-            }
-            gs->layers.push_back(std::move(newLayer));
-        }
-    };
-
-    LayerVisitor visitor(state, gs, res);
-    for (auto& layer: res->map->layers)
-    {
-        std::visit(visitor, layer);
-    }
-
-    assert(gs->playerIndex != -1);
-}
-
-void drawParallaxBackground(
-        SDL_Renderer* renderer, SDL_Texture* texture, const float xVelocity, float& scrollPos,
-        const float scrollFactor, const float deltaTime)
-{
-    scrollPos -= xVelocity * scrollFactor * deltaTime;
-    if (scrollPos <= -texture->w)
-    {
-        scrollPos = 0;
-    }
-
-    // double the dest width makes SDL_RenderTextureTiled draw same texture twice
-    // avoiding calling renderTexture twice
-    const SDL_FRect dst
-    {
-            scrollPos, 30, texture->w * 2.0f,
-            static_cast<float>(texture->h)
-    };
-
-#if EMSCRIPTEN
-    SDL_RenderTexture(renderer, texture, nullptr, &dst);
-#else
-    SDL_RenderTextureTiled(renderer, texture, nullptr, 1, &dst);
-#endif
+    std::string path = std::string(prefPath) + "quicksave.bin";
+    SDL_free(prefPath);
+    return path;
 }
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Writes a random TMX map and its TSX tileset, to see how the game scales with map size.
+//
+//     sdl3-demo-mapgen <map.tmx> [--width=100] [--height=20] [--density=0.1] [--layers=1]
+//                      [--enemies=10] [--players=1] [--seed=1] [--animate]
+//
+// density is the fraction of the Level layer covered by platforms and of every decoration
+// layer covered by panels. Extra layers alternate between background and foreground.
+// The tileset is written next to the map and uses the tiles from data/tiles. --animate makes
+// the panels flicker between two tiles, to try animated tiles at scale.
+
+namespace
+{
+    constexpr int TILE_SIZE = 32;
+
+    // tile ids in the generated tileset, 0 is empty
+    enum Tile : char
+    {
+        EMPTY, BRICK, GRASS, GROUND, PANEL
+    };
+    constexpr const char* TILE_IMAGES[] = {"brick.png", "grass.png", "ground.png", "panel.png"};
+
+    struct Options
+    {
+        std::string mapPath{};
+        int width = 100, height = 20;
+        float density = 0.1f;
+        int layers = 1;
+        int enemies = 10, players = 1;
+        unsigned seed = 1;
+        bool animate{};
+    };
+
+    template<typename T>
+    bool parseValue(const std::string_view text, T& value)
+    {
+        const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc() && end == text.data() + text.size();
+    }
+
+    bool parseOptions(const int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            const size_t eq = arg.find('=');
+            const std::string_view name = arg.substr(0, eq);
+            const std::string_view value = eq == std::string_view::npos ? "" : arg.substr(eq + 1);
+            bool ok;
+            if (!arg.starts_with("--"))
+            {
+                ok = options.mapPath.empty();
+                options.mapPath = arg;
+            }
+            else if (name == "--width")
+            {
+                ok = parseValue(value, options.width);
+            }
+            else if (name == "--height")
+            {
+                ok = parseValue(value, options.height);
+            }
+            else if (name == "--density")
+            {
+                ok = parseValue(value, options.density);
+            }
+            else if (name == "--layers")
+            {
+                ok = parseValue(value, options.layers);
+            }
+            else if (name == "--enemies")
+            {
+                ok = parseValue(value, options.enemies);
+            }
+            else if (name == "--players")
+            {
+                ok = parseValue(value, options.players);
+            }
+            else if (name == "--seed")
+            {
+                ok = parseValue(value, options.seed);
+            }
+            else if (name == "--animate")
+            {
+                options.animate = true;
+                ok = value.empty();
+            }
+            else
+            {
+                ok = false;
+            }
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        // room for the ground and a platform row with headroom
+        return !options.mapPath.empty() && options.width >= 4 && options.height >= 6 &&
+               options.layers >= 1 && options.players >= 1 && options.enemies >= 0 &&
+               options.density >= 0 && options.density <= 1;
+    }
+
+    class Generator
+    {
+    public:
+
+        explicit Generator(const Options& options)
+            : options(options), w(options.width), h(options.height), rng(options.seed),
+              level(w * h, EMPTY)
+        {
+        }
+
+        void generateLevel()
+        {
+            for (int c = 0; c < w; ++c)
+            {
+                level[(h - 2) * w + c] = GRASS;
+                level[(h - 1) * w + c] = GROUND;
+            }
+
+            // platforms between the top two rows and the row above the ground
+            std::uniform_int_distribution<int> row(2, h - 4);
+            std::uniform_int_distribution<int> col(0, w - 1);
+            std::uniform_int_distribution<int> length(3, 8);
+            const long long target = static_cast<long long>(options.density * w * (h - 5));
+            long long filled = 0;
+            // overlapping platforms add nothing, so give up eventually on dense maps
+            for (long long attempts = target * 4; filled < target && attempts > 0; --attempts)
+            {
+                const int r = row(rng);
+                const int c0 = col(rng);
+                for (int c = c0; c < std::min(w, c0 + length(rng)); ++c)
+                {
+                    filled += level[r * w + c] == EMPTY;
+                    level[r * w + c] = BRICK;
+                }
+            }
+        }
+
+        bool write()
+        {
+            const std::filesystem::path mapPath(options.mapPath);
+            const std::string tileSetName = mapPath.stem().string() + ".tsx";
+            return writeTileSet(mapPath.parent_path() / tileSetName) &&
+                   writeMap(mapPath, tileSetName);
+        }
+
+    private:
+
+        const Options& options;
+        int w, h;
+        std::mt19937 rng;
+        std::vector<char> level;
+        int nextId = 1;
+
+        bool writeTileSet(const std::filesystem::path& path) const
+        {
+            std::FILE* file = std::fopen(path.string().c_str(), "w");
+            if (file == nullptr)
+            {
+                return false;
+            }
+            std::println(file, R"(<?xml version="1.0" encoding="UTF-8"?>)");
+            std::println(
+                    file,
+                    R"(<tileset version="1.10" tiledversion="1.10.2" name="{}" tilewidth="{}" )"
+                    R"(tileheight="{}" tilecount="{}" columns="0">)",
+                    path.stem().string(), TILE_SIZE, TILE_SIZE, std::size(TILE_IMAGES));
+            std::println(file, R"( <grid orientation="orthogonal" width="1" height="1"/>)");
+            for (size_t id = 0; id < std::size(TILE_IMAGES); ++id)
+            {
+                std::println(file, R"( <tile id="{}">)", id);
+                std::println(
+                        file, R"(  <image width="{}" height="{}" source="../tiles/{}"/>)",
+                        TILE_SIZE, TILE_SIZE, TILE_IMAGES[id]);
+                if (options.animate && id == PANEL - 1)
+                {
+                    std::println(file, "  <animation>");
+                    std::println(file, R"(   <frame tileid="{}" duration="400"/>)", PANEL - 1);
+                    std::println(file, R"(   <frame tileid="{}" duration="200"/>)", BRICK - 1);
+                    std::println(file, "  </animation>");
+                }
+                std::println(file, " </tile>");
+            }
+            std::println(file, "</tileset>");
+            return std::fclose(file) == 0;
+        }
+
+        bool writeMap(const std::filesystem::path& path, const std::string& tileSetName)
+        {
+            std::FILE* file = std::fopen(path.string().c_str(), "w");
+            if (file == nullptr)
+            {
+                return false;
+            }
+            // big maps are mostly CSV, a large buffer keeps the writes cheap
+            std::vector<char> buffer(1 << 20);
+            std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+            const int backgrounds = (options.layers - 1) / 2;
+            const int foregrounds = options.layers - 1 - backgrounds;
+            std::println(file, R"(<?xml version="1.0" encoding="UTF-8"?>)");
+            std::println(
+                    file,
+                    R"(<map version="1.10" tiledversion="1.10.2" orientation="orthogonal" )"
+                    R"(renderorder="right-down" width="{}" height="{}" tilewidth="{}" )"
+                    R"(tileheight="{}" infinite="0" nextlayerid="{}" nextobjectid="{}">)",
+                    w, h, TILE_SIZE, TILE_SIZE, options.layers + 2,
+                    options.players + options.enemies + 1);
+            std::println(file, R"( <tileset firstgid="1" source="{}"/>)", tileSetName);
+            for (int i = 0; i < backgrounds; ++i)
+            {
+                writeDecoration(file, "Background" + std::to_string(i + 1));
+            }
+            writeLayer(file, "Level", [this](const int i)
+            {
+                return level[i];
+            });
+            writeObjects(file);
+            for (int i = 0; i < foregrounds; ++i)
+            {
+                writeDecoration(file, "Foreground" + std::to_string(i + 1));
+            }
+            std::println(file, "</map>");
+            return std::fclose(file) == 0;
+        }
+
+        void writeDecoration(std::FILE* file, const std::string& name)
+        {
+            std::bernoulli_distribution panel(options.density);
+            writeLayer(file, name, [&](int)
+            {
+                return panel(rng) ? PANEL : EMPTY;
+            });
+        }
+
+        template<typename TileAt>
+        void writeLayer(std::FILE* file, const std::string& name, TileAt tileAt)
+        {
+            std::println(
+                    file, R"( <layer id="{}" name="{}" width="{}" height="{}">)", nextId++, name,
+                    w, h);
+            std::println(file, R"(  <data encoding="csv">)");
+            for (int r = 0; r < h; ++r)
+            {
+                for (int c = 0; c < w; ++c)
+                {
+                    std::fputc('0' + tileAt(r * w + c), file);
+                    if (c < w - 1 || r < h - 1)
+                    {
+                        std::fputc(',', file);
+                    }
+                }
+                std::fputc('\n', file);
+            }
+            std::println(file, "</data>");
+            std::println(file, " </layer>");
+        }
+
+        void writeObjects(std::FILE* file)
+        {
+            std::println(file, R"( <objectgroup id="{}" name="Objects">)", nextId++);
+            int objectId = 1;
+            const auto writeObject = [&](const char* type, const int r, const int c)
+            {
+                // object positions are tile centres
+                std::println(
+                        file, R"(  <object id="{}" name="{}" type="{}" x="{}" y="{}"/>)",
+                        objectId++, type, type, c * TILE_SIZE + TILE_SIZE / 2,
+                        r * TILE_SIZE + TILE_SIZE / 2);
+            };
+
+            // the game follows the last player, keep it near the left edge
+            for (int i = 0; i < options.players; ++i)
+            {
+                writeObject("player", h - 3, std::min(2 + i, w - 1));
+            }
+
+            // enemies stand anywhere something solid is below an empty cell
+            std::uniform_int_distribution<int> col(0, w - 1);
+            std::vector<int> rows;
+            for (int placed = 0; placed < options.enemies;)
+            {
+                const int c = col(rng);
+                rows.clear();
+                for (int r = 0; r < h - 1; ++r)
+                {
+                    if (level[r * w + c] == EMPTY && level[(r + 1) * w + c] != EMPTY)
+                    {
+                        rows.push_back(r);
+                    }
+                }
+                std::uniform_int_distribution<size_t> pick(0, rows.size() - 1);
+                writeObject("enemy", rows[pick(rng)], c);
+                ++placed;
+            }
+            std::println(file, " </objectgroup>");
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::println(
+                stderr,
+                "usage: {} <map.tmx> [--width=100] [--height=20] [--density=0.1] [--layers=1] "
+                "[--enemies=10] [--players=1] [--seed=1] [--animate]", argv[0]);
+        return 1;
+    }
+
+    Generator generator(options);
+    generator.generateLevel();
+    if (!generator.write())
+    {
+        std::println(stderr, "Failed to write {}", options.mapPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "memory.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<size_t> allocations{0};
+}
+
+FrameArena::FrameArena(const size_t capacity)
+    : buffer(capacity),
+      arena(buffer.data(), buffer.size(), std::pmr::new_delete_resource())
+{
+}
+
+std::pmr::memory_resource* FrameArena::resource()
+{
+    return &arena;
+}
+
+void FrameArena::reset()
+{
+    arena.release();
+}
+
+size_t memory::allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+// count every global heap allocation, so the profiler can show what a frame costs
+void* operator new(const std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that only lives during one frame. Everything allocated from it
+// is given back at once by reset() at the top of the frame; if the buffer runs out it
+// falls back to the global heap, which shows up in the allocation counter.
+class FrameArena
+{
+public:
+
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+
+    std::pmr::memory_resource* resource();
+    void reset();
+
+private:
+
+    std::vector<std::byte> buffer;
+    std::pmr::monotonic_buffer_resource arena;
+};
+
+namespace memory
+{
+    // number of global operator new calls since startup
+    size_t allocationCount();
+}
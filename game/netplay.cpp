@@ -0,0 +1,368 @@
+#include "netplay.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t PACKET_MAGIC = 0x4b4c4252; // "RBLK"
+
+#ifdef _WIN32
+    constexpr uintptr_t NO_SOCKET = INVALID_SOCKET;
+#else
+    constexpr int NO_SOCKET = -1;
+#endif
+
+    static_assert(sizeof(sockaddr_in) <= 16);
+}
+
+UdpSocket::~UdpSocket()
+{
+    if (handle == NO_SOCKET)
+    {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(handle);
+#else
+    close(handle);
+#endif
+}
+
+bool UdpSocket::open(const uint16_t port)
+{
+#ifdef _WIN32
+    static const bool started = []
+    {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    if (!started)
+    {
+        return false;
+    }
+#endif
+    handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == NO_SOCKET)
+    {
+        return false;
+    }
+    // the game polls once per frame, it must never wait on the socket
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(handle, FIONBIO, &nonBlocking);
+#else
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK);
+#endif
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    return bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+}
+
+bool UdpSocket::setPeer(const std::string& host, const uint16_t port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+    {
+        return false;
+    }
+    std::memcpy(peer.data(), &address, sizeof(address));
+    hasPeer = true;
+    return true;
+}
+
+uint16_t UdpSocket::localPort() const
+{
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (getsockname(handle, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+    {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+bool UdpSocket::send(const void* data, const size_t size) const
+{
+    if (handle == NO_SOCKET || !hasPeer)
+    {
+        return false;
+    }
+    return sendto(
+                   handle, static_cast<const char*>(data), static_cast<int>(size), 0,
+                   reinterpret_cast<const sockaddr*>(peer.data()), sizeof(sockaddr_in)) ==
+           static_cast<int>(size);
+}
+
+int UdpSocket::receive(void* data, const size_t size) const
+{
+    if (handle == NO_SOCKET)
+    {
+        return -1;
+    }
+    const auto received = recv(handle, static_cast<char*>(data), static_cast<int>(size), 0);
+    return received < 0 ? -1 : static_cast<int>(received);
+}
+
+RollbackSession::RollbackSession(const int localPlayer, const int remotePlayer)
+    : localPlayer(localPlayer), remotePlayer(remotePlayer)
+{
+    remoteFrames.fill(-1);
+    checksums.fill({-1, 0});
+}
+
+bool RollbackSession::open(const uint16_t localPort, const LinkConditions& conditions)
+{
+    this->conditions = conditions;
+    randomState = localPort + 1;
+    return socket.open(localPort);
+}
+
+bool RollbackSession::setPeer(const std::string& host, const uint16_t port)
+{
+    return socket.setPeer(host, port);
+}
+
+uint16_t RollbackSession::localPort() const
+{
+    return socket.localPort();
+}
+
+bool RollbackSession::advance(
+        const SDLState* state, GameState* gs, const Resources* res, const PlayerInput input,
+        const uint64_t nowMs)
+{
+    receive(nowMs);
+
+    // the first tick simulated with a prediction that turned out wrong
+    const int frame = stats.frame;
+    const int confirmed = std::min(stats.confirmedFrame, frame - 1);
+    int rollbackTo = -1;
+    for (int f = checkedFrame + 1; f <= confirmed && rollbackTo < 0; ++f)
+    {
+        if (remoteInputs[f % WINDOW] != usedRemote[f % WINDOW])
+        {
+            rollbackTo = f;
+        }
+    }
+    checkedFrame = std::max(checkedFrame, confirmed);
+
+    if (rollbackTo >= 0)
+    {
+        const uint64_t start = SDL_GetPerformanceCounter();
+        // queued by earlier ticks of this frame, played and spawned at the end of it
+        const size_t sounds = gs->soundEvents.size();
+        const size_t bursts = gs->particleEvents.size();
+        snapshots[rollbackTo % snapshots.size()].restore(*gs, *res);
+        for (int f = rollbackTo; f < frame; ++f)
+        {
+            if (f > rollbackTo)
+            {
+                snapshots[f % snapshots.size()].capture(*gs, *res);
+            }
+            simulate(state, gs, res, f);
+            // these were queued when the tick first ran, they would be heard and seen twice
+            gs->soundEvents.resize(sounds);
+            gs->particleEvents.resize(bursts);
+        }
+        ++stats.rollbacks;
+        stats.lastResimulated = frame - rollbackTo;
+        stats.lastRollbackMs = (SDL_GetPerformanceCounter() - start) * 1000.0f /
+                               SDL_GetPerformanceFrequency();
+        stats.maxRollbackMs = std::max(stats.maxRollbackMs, stats.lastRollbackMs);
+    }
+
+    // a rollback further back than this would need snapshots that are gone
+    if (frame - stats.confirmedFrame > MAX_ROLLBACK)
+    {
+        ++stats.stalls;
+        sendInputs();
+        return false;
+    }
+
+    localInputs[frame % WINDOW] = input;
+    snapshots[frame % snapshots.size()].capture(*gs, *res);
+    simulate(state, gs, res, frame);
+    ++stats.frame;
+    sendInputs();
+    return true;
+}
+
+uint64_t RollbackSession::confirmedChecksum(const int frame) const
+{
+    const auto& [checksumFrame, value] = checksums[frame % WINDOW];
+    return frame <= checkedFrame && checksumFrame == frame ? value : 0;
+}
+
+const RollbackSession::Stats& RollbackSession::getStats() const
+{
+    return stats;
+}
+
+void RollbackSession::sendInputs() const
+{
+    // the oldest inputs the peer is missing, it can't go on without them
+    const int last = stats.frame - 1;
+    const int first = remoteAcked + 1;
+    Packet packet{.magic = PACKET_MAGIC, .ack = stats.confirmedFrame};
+    packet.count = static_cast<uint8_t>(std::clamp(last - first + 1, 0, REDUNDANCY));
+    packet.frame = first + packet.count - 1;
+    for (int i = 0; i < packet.count; ++i)
+    {
+        packet.inputs[i] = localInputs[(first + i) % WINDOW];
+    }
+    socket.send(&packet, sizeof(packet));
+}
+
+void RollbackSession::receive(const uint64_t nowMs)
+{
+    Packet packet;
+    while (socket.receive(&packet, sizeof(packet)) == sizeof(packet))
+    {
+        if (packet.magic != PACKET_MAGIC || packet.count > REDUNDANCY)
+        {
+            continue;
+        }
+        if (SDL_randf_r(&randomState) < conditions.loss)
+        {
+            continue;
+        }
+        const float jitter = (SDL_randf_r(&randomState) * 2 - 1) * conditions.jitterMs;
+        const float delay = std::max(0.0f, conditions.latencyMs + jitter);
+        delayed.push_back({nowMs + static_cast<uint64_t>(delay), packet});
+    }
+
+    // with jitter they come out in a different order than they went in
+    for (const auto& [deliverAt, due]: delayed)
+    {
+        if (deliverAt <= nowMs)
+        {
+            onPacket(due);
+        }
+    }
+    std::erase_if(
+            delayed, [nowMs](const Delayed& d)
+            {
+                return d.deliverAt <= nowMs;
+            });
+}
+
+void RollbackSession::onPacket(const Packet& packet)
+{
+    remoteAcked = std::max(remoteAcked, packet.ack);
+    const int first = packet.frame - packet.count + 1;
+    for (int i = 0; i < packet.count; ++i)
+    {
+        // a slot further ahead would overwrite the last confirmed input, still needed to predict
+        const int f = first + i;
+        if (f > stats.confirmedFrame && f < stats.confirmedFrame + WINDOW)
+        {
+            remoteInputs[f % WINDOW] = packet.inputs[i];
+            remoteFrames[f % WINDOW] = f;
+        }
+    }
+    while (remoteFrames[(stats.confirmedFrame + 1) % WINDOW] == stats.confirmedFrame + 1)
+    {
+        ++stats.confirmedFrame;
+    }
+}
+
+PlayerInput RollbackSession::remoteInput(const int frame) const
+{
+    if (frame <= stats.confirmedFrame)
+    {
+        return remoteInputs[frame % WINDOW];
+    }
+    // predicted, the remote player most likely still holds what it held
+    return stats.confirmedFrame >= 0 ? remoteInputs[stats.confirmedFrame % WINDOW] : PlayerInput{};
+}
+
+void RollbackSession::simulate(
+        const SDLState* state, GameState* gs, const Resources* res, const int frame)
+{
+    gs->inputs[localPlayer] = localInputs[frame % WINDOW];
+    gs->inputs[remotePlayer] = usedRemote[frame % WINDOW] = remoteInput(frame);
+    updateViewport(gs, res);
+    updateGame(state, gs, res, TICK_TIME);
+    // final once the tick is checked against the confirmed input, replaced if rolled back
+    checksums[frame % WINDOW] = {frame, checksum(*gs)};
+}
+
+uint64_t checksum(const GameState& gs)
+{
+    // FNV-1a over the fields one by one, padding bytes are undefined
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](const void* data, const size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+        }
+    };
+    const auto mixObject = [&mix](const GameObject& obj)
+    {
+        mix(&obj.position, sizeof(obj.position));
+        mix(&obj.velocity, sizeof(obj.velocity));
+        mix(&obj.direction, sizeof(obj.direction));
+        switch (obj.type())
+        {
+            case ObjectType::player:
+            {
+                const PlayerData& d = obj.get<PlayerData>();
+                mix(&d.state, sizeof(d.state));
+                break;
+            }
+            case ObjectType::enemy:
+            {
+                const EnemyData& d = obj.get<EnemyData>();
+                mix(&d.state, sizeof(d.state));
+                mix(&d.healthPoints, sizeof(d.healthPoints));
+                break;
+            }
+            case ObjectType::bullet:
+            {
+                const BulletData& d = obj.get<BulletData>();
+                mix(&d.state, sizeof(d.state));
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    };
+
+    for (const auto& layer: gs.layers)
+    {
+        for (const GameObject& obj: layer)
+        {
+            if (obj.dynamic)
+            {
+                mixObject(obj);
+            }
+        }
+    }
+    for (const GameObject& bullet: gs.bullets)
+    {
+        mixObject(bullet);
+    }
+    mix(&gs.randomState, sizeof(gs.randomState));
+    return hash;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.hpp"
+#include "snapshot.hpp"
+
+// A non-blocking UDP socket talking to one peer
+class UdpSocket
+{
+public:
+
+    UdpSocket() = default;
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+    ~UdpSocket();
+
+    // port 0 picks a free one, see localPort()
+    bool open(uint16_t port);
+    bool setPeer(const std::string& host, uint16_t port);
+    [[nodiscard]] uint16_t localPort() const;
+    bool send(const void* data, size_t size) const;
+    // size of the datagram read into data, -1 when nothing is waiting
+    [[nodiscard]] int receive(void* data, size_t size) const;
+
+private:
+
+#ifdef _WIN32
+    uintptr_t handle = ~uintptr_t{};
+#else
+    int handle = -1;
+#endif
+    std::array<uint8_t, 16> peer{}; // sockaddr_in
+    bool hasPeer{};
+};
+
+// Network conditions applied to received packets, to try the netcode on loopback
+struct LinkConditions
+{
+    float latencyMs{};
+    float jitterMs{}; // added latency is anywhere in [-jitter, jitter], so packets reorder
+    float loss{};     // fraction of packets dropped
+};
+
+// GGPO style rollback for two players, one on each end of a UDP socket.
+// Both ends simulate every tick right away, predicting that the remote player keeps
+// holding what it held last. When the real input arrives and differs, the game goes back
+// to the snapshot of that tick and simulates forward again with what was really pressed.
+// Every packet repeats the inputs the peer hasn't acknowledged, so losses cost no resends.
+class RollbackSession
+{
+public:
+
+    // how far the game runs ahead of the last confirmed remote input before it waits
+    static constexpr int MAX_ROLLBACK = 8;
+    // every tick has the same length, so both ends simulate the same thing
+    static constexpr float TICK_TIME = 1.0f / 60.0f;
+
+    struct Stats
+    {
+        int frame{};          // next tick to simulate
+        int confirmedFrame{}; // last tick with the remote input known, -1 before the first
+        int rollbacks{};
+        int stalls{};           // ticks spent waiting for the peer
+        int lastResimulated{};  // ticks simulated again by the last rollback
+        float lastRollbackMs{}; // restore and resimulation time of the last rollback
+        float maxRollbackMs{};
+    };
+
+    RollbackSession(int localPlayer, int remotePlayer);
+
+    // port 0 picks a free one, conditions are applied to everything received
+    bool open(uint16_t localPort, const LinkConditions& conditions = {});
+    bool setPeer(const std::string& host, uint16_t port);
+    [[nodiscard]] uint16_t localPort() const;
+
+    // one tick at time nowMs: reads the peer's inputs, rolls back if a prediction was wrong
+    // and simulates the next tick with input for the local player.
+    // false when it waits for the peer instead, gs is unchanged then.
+    bool advance(
+            const SDLState* state, GameState* gs, const Resources* res, PlayerInput input,
+            uint64_t nowMs);
+    // checksum of the state after tick frame once both inputs for it were known, 0 if gone
+    [[nodiscard]] uint64_t confirmedChecksum(int frame) const;
+    [[nodiscard]] const Stats& getStats() const;
+
+private:
+
+    // inputs and checksums are kept for this many ticks
+    static constexpr int WINDOW = 64;
+    // inputs repeated in every packet, covers a few lost packets in a row
+    static constexpr int REDUNDANCY = 16;
+
+    struct Packet
+    {
+        uint32_t magic{};
+        int32_t frame{};    // tick of the last input in inputs
+        int32_t ack{};      // last tick of the receiver's input the sender has
+        uint8_t count{};    // inputs, for ticks frame - count + 1 to frame
+        PlayerInput inputs[REDUNDANCY]{};
+    };
+
+    struct Delayed
+    {
+        uint64_t deliverAt{};
+        Packet packet{};
+    };
+
+    int localPlayer, remotePlayer;
+    UdpSocket socket{};
+    LinkConditions conditions{};
+    std::vector<Delayed> delayed{}; // received, waiting out the simulated latency
+    Uint64 randomState = 1;        // for the simulated jitter and loss
+
+    std::array<PlayerInput, WINDOW> localInputs{};
+    std::array<PlayerInput, WINDOW> remoteInputs{};
+    std::array<int, WINDOW> remoteFrames{}; // tick in each slot of remoteInputs, -1 if none
+    std::array<PlayerInput, WINDOW> usedRemote{}; // what the last simulation of a tick used
+    std::array<std::pair<int, uint64_t>, WINDOW> checksums{};
+    std::array<Snapshot, MAX_ROLLBACK + 2> snapshots{}; // state at the start of a tick
+    int remoteAcked = -1;  // last local tick the peer has
+    int checkedFrame = -1; // ticks up to here were simulated with the confirmed input
+    Stats stats{.confirmedFrame = -1};
+
+    void sendInputs() const;
+    void receive(uint64_t nowMs);
+    void onPacket(const Packet& packet);
+    [[nodiscard]] PlayerInput remoteInput(int frame) const;
+    void simulate(const SDLState* state, GameState* gs, const Resources* res, int frame);
+};
+
+// fingerprint of what the simulation depends on, equal on both ends unless they desync
+uint64_t checksum(const GameState& gs);
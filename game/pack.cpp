@@ -0,0 +1,412 @@
+#include "pack.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <span>
+
+#include "lz4.hpp"
+
+#if defined(__EMSCRIPTEN__)
+// the pack is embedded in the page's virtual file system, which can't be mapped
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    // compressed files smaller than this fraction of the original are stored compressed
+    constexpr double MIN_SAVING = 0.9;
+
+    uint64_t alignUp(const uint64_t offset)
+    {
+        return (offset + pack::ALIGNMENT - 1) / pack::ALIGNMENT * pack::ALIGNMENT;
+    }
+
+    // a decompressed file, owned by the SDL_IOStream reading it
+    struct MemoryFile
+    {
+        std::vector<std::byte> bytes;
+        size_t position{};
+    };
+
+    Sint64 memorySize(void* userdata)
+    {
+        return static_cast<Sint64>(static_cast<MemoryFile*>(userdata)->bytes.size());
+    }
+
+    Sint64 memorySeek(void* userdata, const Sint64 offset, const SDL_IOWhence whence)
+    {
+        auto* file = static_cast<MemoryFile*>(userdata);
+        const auto size = static_cast<Sint64>(file->bytes.size());
+        Sint64 position = offset;
+        if (whence == SDL_IO_SEEK_CUR)
+        {
+            position += static_cast<Sint64>(file->position);
+        }
+        else if (whence == SDL_IO_SEEK_END)
+        {
+            position += size;
+        }
+        if (position < 0)
+        {
+            SDL_SetError("Seek before the start of the file");
+            return -1;
+        }
+        file->position = static_cast<size_t>(std::min(position, size));
+        return static_cast<Sint64>(file->position);
+    }
+
+    size_t memoryRead(void* userdata, void* ptr, const size_t size, SDL_IOStatus* status)
+    {
+        auto* file = static_cast<MemoryFile*>(userdata);
+        const size_t count = std::min(size, file->bytes.size() - file->position);
+        if (count == 0)
+        {
+            *status = SDL_IO_STATUS_EOF;
+            return 0;
+        }
+        std::memcpy(ptr, file->bytes.data() + file->position, count);
+        file->position += count;
+        return count;
+    }
+
+    bool memoryClose(void* userdata)
+    {
+        delete static_cast<MemoryFile*>(userdata);
+        return true;
+    }
+
+    const SDL_IOStreamInterface MEMORY_FILE = []
+    {
+        SDL_IOStreamInterface iface;
+        SDL_INIT_INTERFACE(&iface);
+        iface.size = memorySize;
+        iface.seek = memorySeek;
+        iface.read = memoryRead;
+        iface.close = memoryClose;
+        return iface;
+    }();
+
+    AssetPack& mountedPack()
+    {
+        static AssetPack pack;
+        return pack;
+    }
+}
+
+bool pack::write(const std::string& directory, const std::string& packPath, const bool compress)
+{
+    struct File
+    {
+        std::string path;
+        std::vector<std::byte> contents;
+        Entry entry;
+    };
+
+    // paths start with the directory's name, the same as the game asks for them
+    const std::filesystem::path root = std::filesystem::path(directory).lexically_normal();
+    std::vector<File> files;
+    std::error_code error;
+    for (const auto& item: std::filesystem::recursive_directory_iterator(root, error))
+    {
+        if (item.is_regular_file())
+        {
+            files.push_back(
+                    {.path = item.path().lexically_relative(root.parent_path()).generic_string()});
+        }
+    }
+    if (error)
+    {
+        SDL_SetError("Can't list %s: %s", directory.c_str(), error.message().c_str());
+        return false;
+    }
+    std::ranges::sort(files, {}, &File::path);
+
+    uint32_t pathsSize = 0;
+    for (File& file: files)
+    {
+        size_t size;
+        void* data = SDL_LoadFile((root.parent_path() / file.path).string().c_str(), &size);
+        if (data == nullptr)
+        {
+            return false;
+        }
+        const std::span bytes(static_cast<const std::byte*>(data), size);
+        file.entry.size = size;
+        file.contents.assign(bytes.begin(), bytes.end());
+        SDL_free(data);
+
+        if (compress)
+        {
+            std::vector<std::byte> compressed = lz4::compress(file.contents);
+            if (compressed.size() < size * MIN_SAVING)
+            {
+                file.contents = std::move(compressed);
+                file.entry.compression = Compression::lz4;
+            }
+        }
+        file.entry.storedSize = file.contents.size();
+        file.entry.pathOffset = pathsSize;
+        file.entry.pathLength = static_cast<uint32_t>(file.path.size());
+        pathsSize += file.entry.pathLength;
+    }
+
+    uint64_t offset = alignUp(sizeof(Header) + files.size() * sizeof(Entry) + pathsSize);
+    for (File& file: files)
+    {
+        file.entry.offset = offset;
+        offset = alignUp(offset + file.entry.storedSize);
+    }
+
+    SDL_IOStream* out = SDL_IOFromFile(packPath.c_str(), "wb");
+    if (out == nullptr)
+    {
+        return false;
+    }
+    const Header header{
+            .magic = MAGIC, .version = VERSION,
+            .entryCount = static_cast<uint32_t>(files.size()), .pathsSize = pathsSize
+    };
+    bool ok = SDL_WriteIO(out, &header, sizeof(header)) == sizeof(header);
+    for (const File& file: files)
+    {
+        ok = ok && SDL_WriteIO(out, &file.entry, sizeof(Entry)) == sizeof(Entry);
+    }
+    for (const File& file: files)
+    {
+        ok = ok && SDL_WriteIO(out, file.path.data(), file.path.size()) == file.path.size();
+    }
+    constexpr std::byte padding[ALIGNMENT]{};
+    for (const File& file: files)
+    {
+        const Sint64 position = SDL_TellIO(out);
+        const size_t pad = position >= 0 ? file.entry.offset - position : 0;
+        ok = ok && position >= 0 && SDL_WriteIO(out, padding, pad) == pad &&
+             SDL_WriteIO(out, file.contents.data(), file.contents.size()) ==
+             file.contents.size();
+    }
+    return SDL_CloseIO(out) && ok;
+}
+
+AssetPack::~AssetPack()
+{
+    close();
+}
+
+bool AssetPack::open(const std::string& filepath)
+{
+    close();
+#if defined(__EMSCRIPTEN__)
+    size_t fileSize;
+    void* contents = SDL_LoadFile(filepath.c_str(), &fileSize);
+    if (contents == nullptr)
+    {
+        return false;
+    }
+    const auto* bytes = static_cast<const std::byte*>(contents);
+    loaded.assign(bytes, bytes + fileSize);
+    SDL_free(contents);
+    data = loaded.data();
+    size = loaded.size();
+#elif defined(_WIN32)
+    file = CreateFileA(
+            filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+    }
+    LARGE_INTEGER fileSize{};
+    if (file == nullptr || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        SDL_SetError("Can't open %s", filepath.c_str());
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data = mapping != nullptr
+               ? static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+               : nullptr;
+    if (data == nullptr)
+    {
+        SDL_SetError("Can't map %s", filepath.c_str());
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int fd = ::open(filepath.c_str(), O_RDONLY);
+    struct stat info{};
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        SDL_SetError("Can't open %s", filepath.c_str());
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+    // the mapping keeps the file open, the descriptor isn't needed anymore
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        SDL_SetError("Can't map %s", filepath.c_str());
+        return false;
+    }
+    data = static_cast<const std::byte*>(mapped);
+    size = static_cast<size_t>(info.st_size);
+#endif
+
+    // checked once here, so finding and reading files can trust the index
+    bool valid = size >= sizeof(pack::Header) && header().magic == pack::MAGIC &&
+                 header().version == pack::VERSION &&
+                 (size - sizeof(pack::Header)) / sizeof(pack::Entry) >= header().entryCount;
+    const uint64_t pathsStart = sizeof(pack::Header) + header().entryCount * sizeof(pack::Entry);
+    valid = valid && size - pathsStart >= header().pathsSize;
+    const auto* entries = reinterpret_cast<const pack::Entry*>(data + sizeof(pack::Header));
+    for (uint32_t i = 0; valid && i < header().entryCount; ++i)
+    {
+        const pack::Entry& entry = entries[i];
+        valid = entry.offset <= size && size - entry.offset >= entry.storedSize &&
+                entry.pathOffset <= header().pathsSize &&
+                header().pathsSize - entry.pathOffset >= entry.pathLength &&
+                (entry.compression == pack::Compression::none
+                     ? entry.storedSize == entry.size
+                     : entry.compression == pack::Compression::lz4);
+    }
+    if (!valid)
+    {
+        SDL_SetError("%s isn't a pack", filepath.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close()
+{
+#if defined(_WIN32) && !defined(__EMSCRIPTEN__)
+    if (data != nullptr)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr)
+    {
+        CloseHandle(file);
+    }
+    file = mapping = nullptr;
+#elif !defined(__EMSCRIPTEN__)
+    if (data != nullptr)
+    {
+        munmap(const_cast<std::byte*>(data), size);
+    }
+#endif
+    loaded.clear();
+    data = nullptr;
+    size = 0;
+}
+
+bool AssetPack::isOpen() const
+{
+    return data != nullptr;
+}
+
+SDL_IOStream* AssetPack::openFile(const std::string_view path) const
+{
+    const pack::Entry* entry = find(path);
+    if (entry == nullptr)
+    {
+        return nullptr;
+    }
+    const std::span stored(data + entry->offset, entry->storedSize);
+    if (entry->compression == pack::Compression::none)
+    {
+        return SDL_IOFromConstMem(stored.data(), stored.size());
+    }
+
+    auto* file = new MemoryFile{std::vector<std::byte>(entry->size)};
+    if (!lz4::decompress(stored, file->bytes))
+    {
+        delete file;
+        SDL_SetError("%.*s is corrupt", static_cast<int>(path.size()), path.data());
+        return nullptr;
+    }
+    SDL_IOStream* io = SDL_OpenIO(&MEMORY_FILE, file);
+    if (io == nullptr)
+    {
+        delete file;
+    }
+    return io;
+}
+
+size_t AssetPack::fileCount() const
+{
+    return isOpen() ? header().entryCount : 0;
+}
+
+const pack::Header& AssetPack::header() const
+{
+    return *reinterpret_cast<const pack::Header*>(data);
+}
+
+const pack::Entry* AssetPack::find(const std::string_view path) const
+{
+    if (!isOpen())
+    {
+        return nullptr;
+    }
+    const std::span entries(
+            reinterpret_cast<const pack::Entry*>(data + sizeof(pack::Header)),
+            header().entryCount);
+    const auto* paths = reinterpret_cast<const char*>(entries.data() + entries.size());
+    const auto pathOf = [paths](const pack::Entry& entry)
+    {
+        return std::string_view(paths + entry.pathOffset, entry.pathLength);
+    };
+
+    // the index is sorted by path
+    const auto itr = std::ranges::lower_bound(entries, path, {}, pathOf);
+    return itr != entries.end() && pathOf(*itr) == path ? &*itr : nullptr;
+}
+
+bool assets::mount(const std::string& packPath)
+{
+    return mountedPack().open(packPath);
+}
+
+void assets::unmount()
+{
+    mountedPack().close();
+}
+
+bool assets::mounted()
+{
+    return mountedPack().isOpen();
+}
+
+SDL_IOStream* assets::open(const std::string& path)
+{
+    if (mounted())
+    {
+        // the pack has every path in one form, "data/maps/../tiles/x.tsx" is "data/tiles/x.tsx"
+        const std::string normalised = std::filesystem::path(path).lexically_normal()
+                                               .generic_string();
+        if (SDL_IOStream* io = mountedPack().openFile(normalised))
+        {
+            return io;
+        }
+    }
+    return SDL_IOFromFile(path.c_str(), "rb");
+}
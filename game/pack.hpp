@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <SDL3/SDL.h>
+
+// The files of data/ in one file: a header, an index sorted by path, the paths, then the
+// contents, every one starting on an ALIGNMENT boundary. Files LZ4 makes smaller are stored
+// compressed, the rest (PNG, OGG) as they are so they can be read in place.
+namespace pack
+{
+    constexpr uint32_t MAGIC = 0x4b434150; // "PACK"
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t ALIGNMENT = 16;
+
+    enum class Compression : uint32_t
+    {
+        none, lz4
+    };
+
+    struct Header
+    {
+        uint32_t magic{}, version{};
+        uint32_t entryCount{};
+        uint32_t pathsSize{}; // bytes of paths after the index
+    };
+
+    struct Entry
+    {
+        uint64_t offset{};     // from the start of the pack
+        uint64_t storedSize{}; // bytes in the pack
+        uint64_t size{};       // bytes once decompressed
+        uint32_t pathOffset{}, pathLength{}; // in the paths, like "data/maps/original.tmx"
+        Compression compression{};
+        uint32_t reserved{};
+    };
+
+    // every file under directory, stored by its path from directory's parent.
+    // false with the reason in SDL_GetError() if something can't be read or written.
+    bool write(const std::string& directory, const std::string& packPath, bool compress);
+}
+
+// A pack opened once and kept in memory: mapped on native platforms, so only the pages
+// read are loaded, and read in full on the web.
+class AssetPack
+{
+public:
+
+    AssetPack() = default;
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+    ~AssetPack();
+
+    // false with the reason in SDL_GetError() if it can't be read or isn't a pack
+    bool open(const std::string& filepath);
+    void close();
+    [[nodiscard]] bool isOpen() const;
+    // a stream over a packed file, nullptr if it isn't in the pack. Uncompressed files are read
+    // straight from the mapping, compressed ones are decompressed into memory the stream owns.
+    [[nodiscard]] SDL_IOStream* openFile(std::string_view path) const;
+    [[nodiscard]] size_t fileCount() const;
+
+private:
+
+    const std::byte* data{};
+    size_t size{};
+    std::vector<std::byte> loaded{}; // where the pack can't be mapped
+#ifdef _WIN32
+    void* file{};
+    void* mapping{};
+#endif
+
+    [[nodiscard]] const pack::Header& header() const;
+    [[nodiscard]] const pack::Entry* find(std::string_view path) const;
+};
+
+// Where the loaders get their files from: the mounted pack, or the disk for anything it
+// doesn't have or when none is mounted.
+namespace assets
+{
+    // where the pack_data target writes the pack, next to data/
+    constexpr const char* DEFAULT_PACK = "data.pack";
+
+    bool mount(const std::string& packPath);
+    void unmount();
+    [[nodiscard]] bool mounted();
+    // nullptr with the reason in SDL_GetError() if the file is nowhere
+    SDL_IOStream* open(const std::string& path);
+}
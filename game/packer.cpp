@@ -0,0 +1,61 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <SDL3/SDL.h>
+
+#include "pack.hpp"
+
+// Packs a directory into one file the game maps at startup instead of opening every asset.
+//
+//     sdl3-demo-pack <data dir> <out.pack> [--no-compress]
+//
+// Paths in the pack start with the directory's name, e.g. data/maps/original.tmx.
+// The pack_data target runs it on data/ and writes data.pack next to the game.
+
+int main(int argc, char* argv[])
+{
+    std::string directory, packPath;
+    bool compress = true;
+    bool ok = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--no-compress")
+        {
+            compress = false;
+        }
+        else if (directory.empty())
+        {
+            directory = arg;
+        }
+        else if (packPath.empty())
+        {
+            packPath = arg;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+    if (!ok || packPath.empty())
+    {
+        std::println(stderr, "usage: {} <data dir> <out.pack> [--no-compress]", argv[0]);
+        return 1;
+    }
+
+    if (!pack::write(directory, packPath, compress))
+    {
+        std::println(stderr, "Failed to pack {}: {}", directory, SDL_GetError());
+        return 1;
+    }
+
+    // read back, so a broken pack fails the build and not the game
+    AssetPack written;
+    if (!written.open(packPath))
+    {
+        std::println(stderr, "Failed to read {} back: {}", packPath, SDL_GetError());
+        return 1;
+    }
+    std::println("Packed {} files into {}", written.fileCount(), packPath);
+    return 0;
+}
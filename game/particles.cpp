@@ -0,0 +1,225 @@
+#include "particles.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    float randomRange(const float min, const float max)
+    {
+        return min + (max - min) * SDL_randf();
+    }
+
+    float lerp(const float a, const float b, const float t)
+    {
+        return a + (b - a) * t;
+    }
+}
+
+int ParticleSystem::Pool::size() const
+{
+    return static_cast<int>(x.size());
+}
+
+void ParticleSystem::Pool::push(
+        const Emitter_ID id, const glm::vec2 position, const glm::vec2 velocity,
+        const float gravity, const float lifetime)
+{
+    x.push_back(position.x);
+    y.push_back(position.y);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    this->gravity.push_back(gravity);
+    age.push_back(0);
+    this->lifetime.push_back(lifetime);
+    emitter.push_back(static_cast<uint32_t>(id));
+}
+
+void ParticleSystem::Pool::integrate(const float deltaTime)
+{
+    // plain loops over separate arrays without branches, so they vectorize
+    const int n = size();
+    float* __restrict px = x.data();
+    float* __restrict py = y.data();
+    float* __restrict pvx = vx.data();
+    float* __restrict pvy = vy.data();
+    const float* __restrict pg = gravity.data();
+    float* __restrict pAge = age.data();
+    for (int i = 0; i < n; ++i)
+    {
+        pvy[i] += pg[i] * deltaTime;
+        px[i] += pvx[i] * deltaTime;
+        py[i] += pvy[i] * deltaTime;
+        pAge[i] += deltaTime;
+    }
+}
+
+void ParticleSystem::Pool::removeDead()
+{
+    int n = size();
+    for (int i = 0; i < n;)
+    {
+        if (age[i] < lifetime[i])
+        {
+            ++i;
+            continue;
+        }
+        --n;
+        x[i] = x[n];
+        y[i] = y[n];
+        vx[i] = vx[n];
+        vy[i] = vy[n];
+        gravity[i] = gravity[n];
+        age[i] = age[n];
+        lifetime[i] = lifetime[n];
+        emitter[i] = emitter[n];
+    }
+    resize(n);
+}
+
+void ParticleSystem::Pool::resize(const int n)
+{
+    // shrinking keeps the capacity, refilling the pool doesn't allocate
+    for (auto* field: {&x, &y, &vx, &vy, &gravity, &age, &lifetime})
+    {
+        field->resize(n);
+    }
+    emitter.resize(n);
+}
+
+void ParticleSystem::process(
+        const std::span<const ParticleEmitter> emitters, std::vector<ParticleEvent>& events)
+{
+    for (const auto& [id, position, direction]: events)
+    {
+        emit(emitters[id], id, position, direction);
+    }
+    events.clear();
+}
+
+void ParticleSystem::emit(
+        const ParticleEmitter& emitter, const Emitter_ID id, const glm::vec2 position,
+        const float direction)
+{
+    Pool& pool = poolFor(emitter.texture);
+    const int count = std::min(emitter.count, MAX_PARTICLES - alive);
+    for (int i = 0; i < count; ++i)
+    {
+        const float angle = emitter.angle + randomRange(-emitter.spread, emitter.spread);
+        const float speed = randomRange(emitter.speedMin, emitter.speedMax);
+        const glm::vec2 velocity(std::cos(angle) * speed * direction, -std::sin(angle) * speed);
+        pool.push(
+                id, position, velocity, emitter.gravity,
+                randomRange(emitter.lifetimeMin, emitter.lifetimeMax));
+    }
+    alive += count;
+}
+
+void ParticleSystem::update(const float deltaTime)
+{
+    alive = 0;
+    for (Pool& pool: pools)
+    {
+        pool.integrate(deltaTime);
+        pool.removeDead();
+        alive += pool.size();
+    }
+    stats.particles = alive;
+}
+
+void ParticleSystem::draw(
+        SDL_Renderer* renderer, const std::span<const ParticleEmitter> emitters,
+        const SDL_FRect& viewport)
+{
+    stats.drawCalls = 0;
+    // untextured quads blend with the draw blend mode, not the texture's
+    SDL_BlendMode blendMode;
+    SDL_GetRenderDrawBlendMode(renderer, &blendMode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (const Pool& pool: pools)
+    {
+        vertices.clear();
+        const float texW = pool.texture ? static_cast<float>(pool.texture->w) : 1.0f;
+        const float texH = pool.texture ? static_cast<float>(pool.texture->h) : 1.0f;
+        // premultiplied textures need the fade premultiplied as well
+        SDL_BlendMode textureBlendMode = SDL_BLENDMODE_BLEND;
+        if (pool.texture)
+        {
+            SDL_GetTextureBlendMode(pool.texture, &textureBlendMode);
+        }
+        const bool premultiplied = textureBlendMode == SDL_BLENDMODE_BLEND_PREMULTIPLIED;
+        for (int i = 0; i < pool.size(); ++i)
+        {
+            const ParticleEmitter& emitter = emitters[pool.emitter[i]];
+            const float t = pool.age[i] / pool.lifetime[i];
+            const float size = lerp(emitter.sizeStart, emitter.sizeEnd, t);
+            const float x0 = pool.x[i] - viewport.x - size / 2;
+            const float y0 = pool.y[i] - viewport.y - size / 2;
+            if (x0 + size < 0 || x0 > viewport.w || y0 + size < 0 || y0 > viewport.h)
+            {
+                continue;
+            }
+            const float x1 = x0 + size, y1 = y0 + size;
+
+            const float alpha = lerp(emitter.colorStart.a, emitter.colorEnd.a, t);
+            const float scale = premultiplied ? alpha : 1.0f;
+            const SDL_FColor color{
+                    lerp(emitter.colorStart.r, emitter.colorEnd.r, t) * scale,
+                    lerp(emitter.colorStart.g, emitter.colorEnd.g, t) * scale,
+                    lerp(emitter.colorStart.b, emitter.colorEnd.b, t) * scale, alpha
+            };
+            const float u0 = emitter.src.x / texW, u1 = (emitter.src.x + emitter.src.w) / texW;
+            const float v0 = emitter.src.y / texH, v1 = (emitter.src.y + emitter.src.h) / texH;
+            vertices.push_back({{x0, y0}, color, {u0, v0}});
+            vertices.push_back({{x1, y0}, color, {u1, v0}});
+            vertices.push_back({{x1, y1}, color, {u1, v1}});
+            vertices.push_back({{x0, y1}, color, {u0, v1}});
+        }
+        if (vertices.empty())
+        {
+            continue;
+        }
+
+        // every quad uses the same pattern, so indices only grow and are never rewritten
+        const int quads = static_cast<int>(vertices.size() / 4);
+        for (int q = static_cast<int>(indices.size() / 6); q < quads; ++q)
+        {
+            for (const int i: {0, 1, 2, 0, 2, 3})
+            {
+                indices.push_back(q * 4 + i);
+            }
+        }
+        SDL_RenderGeometry(
+                renderer, pool.texture, vertices.data(), static_cast<int>(vertices.size()),
+                indices.data(), quads * 6);
+        ++stats.drawCalls;
+    }
+    SDL_SetRenderDrawBlendMode(renderer, blendMode);
+}
+
+void ParticleSystem::clear()
+{
+    for (Pool& pool: pools)
+    {
+        pool.resize(0);
+    }
+    alive = 0;
+    stats.particles = 0;
+}
+
+const ParticleSystem::Stats& ParticleSystem::getStats() const
+{
+    return stats;
+}
+
+ParticleSystem::Pool& ParticleSystem::poolFor(SDL_Texture* texture)
+{
+    const auto itr = std::ranges::find(pools, texture, &Pool::texture);
+    if (itr != pools.end())
+    {
+        return *itr;
+    }
+    Pool& pool = pools.emplace_back();
+    pool.texture = texture;
+    return pool;
+}
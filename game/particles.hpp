@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+
+typedef size_t Emitter_ID;
+
+// What a burst of particles looks like, set up once at load time
+struct ParticleEmitter
+{
+    SDL_Texture* texture{}; // null draws flat coloured squares
+    SDL_FRect src{};        // texels every particle shows, in pixels
+    int count{};            // particles per burst
+    float angle{};          // radians, 0 points right and the burst is mirrored for left
+    float spread{};         // half angle of the cone the particles leave in
+    float speedMin{}, speedMax{};
+    float lifetimeMin{}, lifetimeMax{}; // seconds
+    float gravity{};
+    float sizeStart{}, sizeEnd{};
+    SDL_FColor colorStart{}, colorEnd{}; // blended over the particle's life
+};
+
+// a request for a burst, queued by gameplay code during the frame
+struct ParticleEvent
+{
+    Emitter_ID emitter{};
+    glm::vec2 position{};
+    float direction = 1; // -1 mirrors the emitter's cone
+};
+
+// Short lived particles, kept apart from GameObjects so they never go through update() or
+// collision. Particles are stored as arrays per field and integrated in tight loops the
+// compiler can vectorize. Particles sharing a texture are drawn with one
+// SDL_RenderGeometry call.
+class ParticleSystem
+{
+public:
+
+    struct Stats
+    {
+        int particles{}; // alive after the last update
+        int drawCalls{};
+    };
+
+    // bursts are cut short once this many particles are alive
+    static constexpr int MAX_PARTICLES = 1 << 17;
+
+    // spawns the queued bursts and clears the queue
+    void process(std::span<const ParticleEmitter> emitters, std::vector<ParticleEvent>& events);
+    void emit(const ParticleEmitter& emitter, Emitter_ID id, glm::vec2 position, float direction);
+    // moves every particle and drops the ones past their lifetime
+    void update(float deltaTime);
+    // particles are in map coordinates, viewport is the visible part of the map
+    void draw(
+            SDL_Renderer* renderer, std::span<const ParticleEmitter> emitters,
+            const SDL_FRect& viewport);
+    void clear();
+    [[nodiscard]] const Stats& getStats() const;
+
+private:
+
+    // particles drawn from the same texture
+    struct Pool
+    {
+        SDL_Texture* texture{};
+        std::vector<float> x{}, y{}, vx{}, vy{}, gravity{}, age{}, lifetime{};
+        std::vector<uint32_t> emitter{};
+
+        [[nodiscard]] int size() const;
+        void push(
+                Emitter_ID id, glm::vec2 position, glm::vec2 velocity, float gravity,
+                float lifetime);
+        void integrate(float deltaTime);
+        // swaps the dead with the last alive, order doesn't matter for particles
+        void removeDead();
+        void resize(int n);
+    };
+
+    std::vector<Pool> pools{};
+    // reused by every draw, so drawing doesn't allocate once they are big enough
+    std::vector<SDL_Vertex> vertices{};
+    std::vector<int> indices{};
+    int alive{};
+    Stats stats{};
+
+    Pool& poolFor(SDL_Texture* texture);
+};
@@ -0,0 +1,94 @@
+#include "registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+ObjectHandle ObjectRegistry::add(const ObjectRef ref)
+{
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    Slot& s = slots[slot];
+    s.ref = ref;
+    s.live = true;
+    ++liveCount;
+    return {slot, s.generation};
+}
+
+const ObjectRef* ObjectRegistry::find(const ObjectHandle handle) const
+{
+    if (handle.slot >= slots.size())
+    {
+        return nullptr;
+    }
+    const Slot& s = slots[handle.slot];
+    return s.live && s.generation == handle.generation ? &s.ref : nullptr;
+}
+
+void ObjectRegistry::move(const ObjectHandle handle, const int index)
+{
+    if (find(handle) != nullptr)
+    {
+        slots[handle.slot].ref.index = index;
+    }
+}
+
+void ObjectRegistry::remove(const ObjectHandle handle)
+{
+    if (find(handle) == nullptr)
+    {
+        return;
+    }
+    Slot& s = slots[handle.slot];
+    s.live = false;
+    // skips 0 when it wraps, which would make the next handle null
+    s.generation = std::max(s.generation + 1, 1u);
+    freeSlots.push_back(handle.slot);
+    --liveCount;
+}
+
+void ObjectRegistry::removeLayer(const int layer)
+{
+    for (uint32_t slot = 0; slot < slots.size(); ++slot)
+    {
+        if (slots[slot].live && slots[slot].ref.layer == layer)
+        {
+            remove({slot, slots[slot].generation});
+        }
+    }
+}
+
+size_t ObjectRegistry::size() const
+{
+    return liveCount;
+}
+
+std::span<const ObjectRegistry::Slot> ObjectRegistry::getSlots() const
+{
+    return slots;
+}
+
+std::span<const uint32_t> ObjectRegistry::getFreeSlots() const
+{
+    return freeSlots;
+}
+
+void ObjectRegistry::assign(
+        const std::byte* slots, const size_t slotCount, const std::byte* freeSlots,
+        const size_t freeSlotCount)
+{
+    // keeps the storage, restoring a snapshot of the same game doesn't allocate
+    this->slots.resize(slotCount);
+    std::memcpy(this->slots.data(), slots, slotCount * sizeof(Slot));
+    this->freeSlots.resize(freeSlotCount);
+    std::memcpy(this->freeSlots.data(), freeSlots, freeSlotCount * sizeof(uint32_t));
+    liveCount = std::ranges::count(this->slots, true, &Slot::live);
+}
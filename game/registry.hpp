@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// where a dynamic object is in GameState::layers
+struct ObjectRef
+{
+    int layer{}, index{};
+};
+
+// Names a dynamic object for as long as it lives, wherever compaction moves it. A slot is
+// reused once its object is destroyed, with the generation bumped, so old handles to it find
+// nothing instead of whatever took its place.
+struct ObjectHandle
+{
+    uint32_t slot{};
+    uint32_t generation{}; // never 0 once handed out, so a default handle names nothing
+
+    explicit operator bool() const
+    {
+        return generation != 0;
+    }
+
+    bool operator==(const ObjectHandle&) const = default;
+};
+
+// The handles of the dynamic objects in GameState::layers and where each of them is now.
+// Bullets are pooled in GameState::bullets instead and have none.
+class ObjectRegistry
+{
+public:
+
+    struct Slot
+    {
+        ObjectRef ref{};
+        uint32_t generation = 1; // of the object in it, or of the next one while it is free
+        bool live{};
+    };
+
+    ObjectHandle add(ObjectRef ref);
+    // where the object is, nullptr once it has been destroyed
+    [[nodiscard]] const ObjectRef* find(ObjectHandle handle) const;
+    // the object now is at index of the same layer
+    void move(ObjectHandle handle, int index);
+    // handle names nothing from now on, its slot goes to a later add()
+    void remove(ObjectHandle handle);
+    // every object in layer, e.g. when the layer is rebuilt
+    void removeLayer(int layer);
+    [[nodiscard]] size_t size() const;
+
+    // the whole state, so snapshots can put it back as it was
+    [[nodiscard]] std::span<const Slot> getSlots() const;
+    [[nodiscard]] std::span<const uint32_t> getFreeSlots() const;
+    // what getSlots() and getFreeSlots() returned, copied as bytes at any alignment
+    void assign(
+            const std::byte* slots, size_t slotCount, const std::byte* freeSlots,
+            size_t freeSlotCount);
+
+private:
+
+    std::vector<Slot> slots{};
+    std::vector<uint32_t> freeSlots{}; // reused last in, first out
+    size_t liveCount{};
+};
@@ -0,0 +1,135 @@
+#include "resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "textures.hpp"
+
+void ResolutionScaler::init(
+        SDL_Renderer* renderer, const int logW, const int logH, const float minScale,
+        const float maxScale, const float budgetMs)
+{
+    this->renderer = renderer;
+    this->logW = logW;
+    this->logH = logH;
+    this->minScale = minScale;
+    this->maxScale = maxScale;
+    this->budgetMs = budgetMs;
+    // starts as sharp as allowed and comes down if that is too slow
+    scale = maxScale;
+    drawMs = 0;
+    framesAtScale = 0;
+    drawing = false;
+    target = {};
+}
+
+bool ResolutionScaler::begin()
+{
+    frameStart = SDL_GetPerformanceCounter();
+
+    // past one texel per window pixel the blit would only shrink what was drawn bigger
+    int outW, outH;
+    if (!SDL_GetRenderOutputSize(renderer, &outW, &outH))
+    {
+        return false;
+    }
+    const float fit = std::min(
+            static_cast<float>(outW) / static_cast<float>(logW),
+            static_cast<float>(outH) / static_cast<float>(logH));
+    limit = std::max(std::min(maxScale, fit), minScale);
+    scale = std::clamp(scale, minScale, limit);
+
+    drawing = resize() && SDL_SetRenderTarget(renderer, target);
+    return drawing;
+}
+
+void ResolutionScaler::end()
+{
+    if (!drawing)
+    {
+        return;
+    }
+    drawing = false;
+    SDL_SetRenderTarget(renderer, nullptr);
+    // the letterbox bars, then the game through the window's logical presentation
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    SDL_RenderTexture(renderer, target, nullptr, nullptr);
+    // the software renderer only draws when flushed, present would add the wait for vsync
+    SDL_FlushRenderer(renderer);
+
+    const float ms = (SDL_GetPerformanceCounter() - frameStart) * 1000.0f /
+                     SDL_GetPerformanceFrequency();
+    drawMs = framesAtScale == 0 ? ms : drawMs + (ms - drawMs) * 0.1f;
+    const SDL_Texture* texture = target;
+    stats = {texture->w, texture->h, scale, drawMs};
+    adapt();
+}
+
+const ResolutionScaler::Stats& ResolutionScaler::getStats() const
+{
+    return stats;
+}
+
+bool ResolutionScaler::resize()
+{
+    const int w = std::max(1, static_cast<int>(std::lround(logW * scale)));
+    const int h = std::max(1, static_cast<int>(std::lround(logH * scale)));
+    if (const SDL_Texture* texture = target; texture && texture->w == w && texture->h == h)
+    {
+        return true;
+    }
+
+    target = {
+            SDL_CreateTexture(
+                    renderer, textures::preferredFormat(renderer, false),
+                    SDL_TEXTUREACCESS_TARGET, w, h),
+            SDL_DestroyTexture
+    };
+    if (!target)
+    {
+        SDL_Log("Drawing at the window's resolution, no %dx%d target: %s", w, h, SDL_GetError());
+        return false;
+    }
+    // opaque and copied texel for texel, blended or filtered it would cost more and blur
+    SDL_SetTextureBlendMode(target, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(target, SDL_SCALEMODE_NEAREST);
+    // the texture's own presentation, so the game draws at logical coordinates whatever its size
+    SDL_SetRenderTarget(renderer, target);
+    SDL_SetRenderLogicalPresentation(renderer, logW, logH, SDL_LOGICAL_PRESENTATION_STRETCH);
+    return true;
+}
+
+void ResolutionScaler::adapt()
+{
+    if (++framesAtScale < SETTLE_FRAMES)
+    {
+        return;
+    }
+
+    // a frame costs about its pixel count, scale squared
+    float next = scale;
+    if (drawMs > budgetMs)
+    {
+        // straight down to where it should fit, a step at least
+        const float fits = scale * std::sqrt(budgetMs / drawMs);
+        next = std::min(std::floor(fits / SCALE_STEP) * SCALE_STEP, scale - SCALE_STEP);
+    }
+    else
+    {
+        // a step up, if it would still leave a tenth of the budget
+        const float up = std::min((std::floor(scale / SCALE_STEP) + 1) * SCALE_STEP, limit);
+        if (drawMs * (up / scale) * (up / scale) < budgetMs * 0.9f)
+        {
+            next = up;
+        }
+    }
+    next = std::clamp(next, minScale, limit);
+    if (next != scale)
+    {
+        // what the new size should cost until it is measured
+        drawMs *= (next / scale) * (next / scale);
+        scale = next;
+        framesAtScale = 1;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <autorelease/AutoRelease.hpp>
+
+// Draws the game into a texture of its own, at logical coordinates, and that texture onto the
+// window in one nearest neighbour blit. On the software renderer filling the window is what a
+// frame costs, so the texture shrinks when frames take longer than the budget and grows back
+// when there is time to spare, between the scales given to init(), in multiples of the
+// logical size. It never grows past what the window shows.
+class ResolutionScaler
+{
+public:
+
+    struct Stats
+    {
+        int width{}, height{}; // of the texture drawn into
+        float scale{};
+        float drawMs{}; // smoothed, from begin() to the blit onto the window being done
+    };
+
+    // the internal resolution changes in steps of this much of the logical size
+    static constexpr float SCALE_STEP = 0.125f;
+    // frames the draw time is measured at a resolution before it changes again
+    static constexpr int SETTLE_FRAMES = 30;
+
+    // budgetMs is what drawing a frame may take, maxScale may be larger than the window
+    void init(
+            SDL_Renderer* renderer, int logW, int logH, float minScale, float maxScale,
+            float budgetMs);
+    // everything drawn until end() goes to the texture, false if it can't be made and it
+    // goes to the window as it is
+    bool begin();
+    // draws the texture onto the window, under whatever is drawn after, and picks the
+    // resolution of the next frame
+    void end();
+    [[nodiscard]] const Stats& getStats() const;
+
+private:
+
+    SDL_Renderer* renderer{};
+    AutoRelease<SDL_Texture*> target{};
+    int logW{}, logH{};
+    float minScale{}, maxScale{}, budgetMs{};
+    float scale{};
+    float limit{}; // maxScale or what the window shows, whichever is smaller
+    float drawMs{};
+    int framesAtScale{};
+    Uint64 frameStart{};
+    bool drawing{}; // into target, since begin()
+    Stats stats{};
+
+    bool resize();
+    void adapt();
+};
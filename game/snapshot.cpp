@@ -0,0 +1,422 @@
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+#include <SDL3/SDL.h>
+
+#include "game.hpp"
+
+namespace
+{
+    constexpr uint32_t MAGIC = 0x50414e53; // "SNAP"
+    constexpr uint32_t VERSION = 3;
+    constexpr uint8_t NO_TEXTURE = 0xff;
+
+    // every sheet a dynamic object can show, stored as an index so saves work across runs
+    constexpr const AtlasRegion* Resources::* TEXTURES[] = {
+            &Resources::texIdle, &Resources::texRun, &Resources::texSlide,
+            &Resources::texShoot, &Resources::texRunShoot, &Resources::texSlideShoot,
+            &Resources::texBullet, &Resources::texBulletHit, &Resources::texEnemy,
+            &Resources::texEnemyHit, &Resources::texEnemyDie,
+    };
+
+    // copied as bytes, so they must stay plain data
+    static_assert(std::is_trivially_copyable_v<ObjectData>);
+    static_assert(std::is_trivially_copyable_v<Animation>);
+    static_assert(std::is_trivially_copyable_v<ObjectRegistry::Slot>);
+
+    struct Header
+    {
+        uint32_t magic{}, version{};
+        uint32_t layerCount{}, objectCount{}, bulletCount{};
+        uint32_t slotCount{}, freeSlotCount{}; // of GameState::registry, after the bullets
+        ObjectHandle player{};
+        SDL_FRect mapViewport{};
+        Uint64 randomState{};
+    };
+
+    // everything in a GameObject that changes during play, followed by its animations
+    struct ObjectRecord
+    {
+        uint32_t layer{}, index{}; // position in GameState::layers, unused for bullets
+        ObjectData data{LevelData{}}; // its index is the type
+        ObjectHandle handle{};
+        CollisionFilter collision{};
+        glm::vec2 position{}, velocity{}, acceleration{};
+        float direction{}, maxSpeedX{};
+        SDL_FRect collider{};
+        Timer flashTimer{0};
+        float restTime{};
+        int32_t currentAnimation{}, spriteFrame{};
+        uint8_t texture{}, animationCount{};
+        bool dynamic{}, grounded{}, shouldFlash{}, sleeping{};
+    };
+
+    template<typename T>
+    void put(std::vector<std::byte>& buffer, const T& value)
+    {
+        const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    class Reader
+    {
+    public:
+
+        explicit Reader(const std::vector<std::byte>& buffer) : buffer(buffer)
+        {
+        }
+
+        // false once the buffer runs out
+        bool read(void* out, const size_t size)
+        {
+            if (buffer.size() - offset < size)
+            {
+                return false;
+            }
+            std::memcpy(out, buffer.data() + offset, size);
+            offset += size;
+            return true;
+        }
+
+        template<typename T>
+        bool get(T& value)
+        {
+            return read(&value, sizeof(T));
+        }
+
+        bool skip(const size_t size)
+        {
+            return take(size) != nullptr;
+        }
+
+        // the next size bytes where they are, nullptr if the buffer runs out
+        const std::byte* take(const size_t size)
+        {
+            if (buffer.size() - offset < size)
+            {
+                return nullptr;
+            }
+            offset += size;
+            return buffer.data() + offset - size;
+        }
+
+    private:
+
+        const std::vector<std::byte>& buffer;
+        size_t offset{};
+    };
+
+    // object groups hold nothing but dynamic objects, so they are put back whole from their
+    // records, at whatever size compaction left them. Other layers keep their size.
+    bool isObjectGroup(const Resources& res, const size_t layer)
+    {
+        return layer < res.map->layers.size() &&
+               std::holds_alternative<tmx::ObjectGroup>(res.map->layers[layer]);
+    }
+
+    // tile layers only hold tiles, unless a map reload left the player in one
+    bool hasDynamicObjects(const GameState& gs, const Resources& res, const size_t layer)
+    {
+        return layer >= res.map->layers.size() || static_cast<int>(layer) == gs.playerLayer() ||
+               isObjectGroup(res, layer);
+    }
+
+    void putObject(
+            std::vector<std::byte>& buffer, const Resources& res, const GameObject& obj,
+            const uint32_t layer, const uint32_t index)
+    {
+        const auto texture = std::ranges::find_if(
+                TEXTURES, [&](const AtlasRegion* Resources::* tex)
+                {
+                    return res.*tex == obj.texture;
+                });
+        put(buffer, ObjectRecord{
+                    .layer = layer, .index = index, .data = obj.data, .handle = obj.handle,
+                    .collision = obj.collision,
+                    .position = obj.position, .velocity = obj.velocity,
+                    .acceleration = obj.acceleration, .direction = obj.direction,
+                    .maxSpeedX = obj.maxSpeedX, .collider = obj.collider,
+                    .flashTimer = obj.flashTimer, .restTime = obj.restTime,
+                    .currentAnimation = obj.currentAnimation, .spriteFrame = obj.spriteFrame,
+                    .texture = static_cast<uint8_t>(texture == std::end(TEXTURES)
+                                                        ? NO_TEXTURE
+                                                        : texture - std::begin(TEXTURES)),
+                    .animationCount = static_cast<uint8_t>(obj.animations.size()),
+                    .dynamic = obj.dynamic, .grounded = obj.grounded,
+                    .shouldFlash = obj.shouldFlash, .sleeping = obj.sleeping
+            });
+        const auto* animations = reinterpret_cast<const std::byte*>(obj.animations.data());
+        buffer.insert(
+                buffer.end(), animations, animations + obj.animations.size() * sizeof(Animation));
+    }
+
+    // the record is already read, its animations are next in reader
+    void applyObject(
+            Reader& reader, const Resources& res, const ObjectRecord& record, GameObject& obj)
+    {
+        obj.data = record.data;
+        obj.handle = record.handle;
+        obj.collision = record.collision;
+        obj.position = record.position;
+        obj.velocity = record.velocity;
+        obj.acceleration = record.acceleration;
+        obj.direction = record.direction;
+        obj.maxSpeedX = record.maxSpeedX;
+        obj.collider = record.collider;
+        obj.flashTimer = record.flashTimer;
+        obj.restTime = record.restTime;
+        obj.currentAnimation = record.currentAnimation;
+        obj.spriteFrame = record.spriteFrame;
+        if (record.texture < std::size(TEXTURES))
+        {
+            obj.texture = res.*TEXTURES[record.texture];
+        }
+        obj.dynamic = record.dynamic;
+        obj.grounded = record.grounded;
+        obj.shouldFlash = record.shouldFlash;
+        obj.sleeping = record.sleeping;
+        // keeps the vector's storage when the count is the same, which it usually is
+        obj.animations.resize(record.animationCount);
+        reader.read(obj.animations.data(), record.animationCount * sizeof(Animation));
+    }
+}
+
+void Snapshot::capture(const GameState& gs, const Resources& res)
+{
+    buffer.clear();
+    put(buffer, Header{});
+    const size_t layerCount = gs.layers.size();
+    for (const auto& layer: gs.layers)
+    {
+        put(buffer, static_cast<uint32_t>(layer.size()));
+    }
+
+    uint32_t objectCount = 0;
+    for (size_t l = 0; l < layerCount; ++l)
+    {
+        if (!hasDynamicObjects(gs, res, l))
+        {
+            continue;
+        }
+        const auto& layer = gs.layers[l];
+        for (size_t i = 0; i < layer.size(); ++i)
+        {
+            if (layer[i].dynamic)
+            {
+                putObject(buffer, res, layer[i], l, i);
+                ++objectCount;
+            }
+        }
+    }
+    for (const GameObject& bullet: gs.bullets)
+    {
+        putObject(buffer, res, bullet, 0, 0);
+    }
+    const auto slots = gs.registry.getSlots();
+    const auto freeSlots = gs.registry.getFreeSlots();
+    const auto* bytes = reinterpret_cast<const std::byte*>(slots.data());
+    buffer.insert(buffer.end(), bytes, bytes + slots.size_bytes());
+    bytes = reinterpret_cast<const std::byte*>(freeSlots.data());
+    buffer.insert(buffer.end(), bytes, bytes + freeSlots.size_bytes());
+
+    // the counts are only known now
+    const Header header{
+            .magic = MAGIC, .version = VERSION, .layerCount = static_cast<uint32_t>(layerCount),
+            .objectCount = objectCount, .bulletCount = static_cast<uint32_t>(gs.bullets.size()),
+            .slotCount = static_cast<uint32_t>(slots.size()),
+            .freeSlotCount = static_cast<uint32_t>(freeSlots.size()), .player = gs.playerHandle,
+            .mapViewport = gs.mapViewport, .randomState = gs.randomState
+    };
+    std::memcpy(buffer.data(), &header, sizeof(header));
+}
+
+bool Snapshot::restore(GameState& gs, const Resources& res) const
+{
+    // checked in full first, a snapshot that doesn't fit must not leave half a game behind
+    Reader check(buffer);
+    Header header;
+    if (!check.get(header) || header.magic != MAGIC || header.version != VERSION ||
+        header.layerCount != gs.layers.size())
+    {
+        return false;
+    }
+    const std::byte* sizes = check.take(header.layerCount * sizeof(uint32_t));
+    if (sizes == nullptr)
+    {
+        return false;
+    }
+    const auto sizeOf = [sizes](const size_t layer)
+    {
+        uint32_t size;
+        std::memcpy(&size, sizes + layer * sizeof(uint32_t), sizeof(size));
+        return size;
+    };
+    // records of an object group fill it, the others must be the size they are now
+    uint64_t groupObjects = 0;
+    for (size_t l = 0; l < header.layerCount; ++l)
+    {
+        if (isObjectGroup(res, l))
+        {
+            groupObjects += sizeOf(l);
+        }
+        else if (sizeOf(l) != gs.layers[l].size())
+        {
+            return false;
+        }
+    }
+    uint64_t previous = 0; // layer and index of the last record, they only go up
+    for (uint32_t i = 0; i < header.objectCount + header.bulletCount; ++i)
+    {
+        ObjectRecord record;
+        if (!check.get(record) || !check.skip(record.animationCount * sizeof(Animation)) ||
+            record.data.index() >= std::variant_size_v<ObjectData>)
+        {
+            return false;
+        }
+        if (i >= header.objectCount)
+        {
+            if (!std::holds_alternative<BulletData>(record.data))
+            {
+                return false;
+            }
+            continue;
+        }
+        const uint64_t position = uint64_t{record.layer} << 32 | record.index;
+        if ((i > 0 && position <= previous) || record.layer >= gs.layers.size() ||
+            record.index >= sizeOf(record.layer))
+        {
+            return false;
+        }
+        previous = position;
+        if (isObjectGroup(res, record.layer))
+        {
+            --groupObjects;
+        }
+        // objects elsewhere are gone over in place and keep their type
+        else if (!gs.layers[record.layer][record.index].dynamic ||
+                 gs.layers[record.layer][record.index].data.index() != record.data.index())
+        {
+            return false;
+        }
+    }
+    const std::byte* slots = check.take(header.slotCount * sizeof(ObjectRegistry::Slot));
+    const std::byte* freeSlots = check.take(header.freeSlotCount * sizeof(uint32_t));
+    if (groupObjects != 0 || slots == nullptr || freeSlots == nullptr ||
+        header.player.slot >= header.slotCount)
+    {
+        return false;
+    }
+    // every handle must lead into the layers as they will be
+    for (uint32_t i = 0; i < header.slotCount; ++i)
+    {
+        ObjectRegistry::Slot slot;
+        std::memcpy(&slot, slots + i * sizeof(slot), sizeof(slot));
+        const auto [layer, index] = slot.ref;
+        if (slot.live && (layer < 0 || layer >= static_cast<int>(header.layerCount) ||
+                          index < 0 || static_cast<uint32_t>(index) >= sizeOf(layer)))
+        {
+            return false;
+        }
+        if (i == header.player.slot && (!slot.live || slot.generation != header.player.generation))
+        {
+            return false;
+        }
+    }
+
+    Reader reader(buffer);
+    reader.skip(sizeof(Header) + header.layerCount * sizeof(uint32_t));
+    // a layer of another size or with types moved around needs GameState::objectIndex rebuilt
+    bool reshaped = false;
+    for (size_t l = 0; l < header.layerCount; ++l)
+    {
+        reshaped = reshaped || sizeOf(l) != gs.layers[l].size();
+        gs.layers[l].resize(sizeOf(l));
+    }
+    ObjectRecord record;
+    for (uint32_t i = 0; i < header.objectCount; ++i)
+    {
+        reader.get(record);
+        GameObject& obj = gs.layers[record.layer][record.index];
+        reshaped = reshaped || obj.data.index() != record.data.index();
+        applyObject(reader, res, record, obj);
+    }
+    gs.bullets.resize(header.bulletCount);
+    for (GameObject& bullet: gs.bullets)
+    {
+        reader.get(record);
+        applyObject(reader, res, record, bullet);
+    }
+    gs.registry.assign(slots, header.slotCount, freeSlots, header.freeSlotCount);
+    if (reshaped)
+    {
+        gs.objectIndex.layers.clear();
+    }
+
+    gs.playerHandle = header.player;
+    gs.destroyQueue.clear();
+    gs.mapViewport = header.mapViewport;
+    gs.randomState = header.randomState;
+    return true;
+}
+
+size_t Snapshot::size() const
+{
+    return buffer.size();
+}
+
+bool Snapshot::save(const std::string& filepath) const
+{
+    return SDL_SaveFile(filepath.c_str(), buffer.data(), buffer.size());
+}
+
+bool Snapshot::load(const std::string& filepath)
+{
+    size_t size;
+    void* data = SDL_LoadFile(filepath.c_str(), &size);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    const auto* bytes = static_cast<const std::byte*>(data);
+    buffer.assign(bytes, bytes + size);
+    SDL_free(data);
+    return true;
+}
+
+SnapshotRing::SnapshotRing(const int capacity) : slots(capacity)
+{
+}
+
+Snapshot& SnapshotRing::push()
+{
+    newest = (newest + 1) % static_cast<int>(slots.size());
+    count = std::min(count + 1, static_cast<int>(slots.size()));
+    return slots[newest];
+}
+
+const Snapshot* SnapshotRing::get(const int ticksAgo) const
+{
+    if (ticksAgo < 0 || ticksAgo >= count)
+    {
+        return nullptr;
+    }
+    const int capacity = static_cast<int>(slots.size());
+    return &slots[(newest - ticksAgo + capacity) % capacity];
+}
+
+void SnapshotRing::pop(const int count)
+{
+    const int popped = std::min(count, this->count);
+    const int capacity = static_cast<int>(slots.size());
+    newest = (newest - popped + capacity) % capacity;
+    this->count -= popped;
+}
+
+int SnapshotRing::size() const
+{
+    return count;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct GameState;
+struct Resources;
+
+// The simulation state of a GameState in one flat buffer: players, enemies, bullets, the
+// viewport and the random state. Tiles never change during play, so they are left out and
+// a snapshot can only be restored into a game made from the same map.
+// Particles, queued events and derived data like the flow field aren't kept either.
+class Snapshot
+{
+public:
+
+    // reuses the buffer, so capturing the same game again doesn't allocate
+    void capture(const GameState& gs, const Resources& res);
+    // false if the snapshot is empty or from a different map, gs is untouched then
+    bool restore(GameState& gs, const Resources& res) const;
+    [[nodiscard]] size_t size() const;
+
+    bool save(const std::string& filepath) const;
+    // only reads the file, restore() checks it fits the game
+    bool load(const std::string& filepath);
+
+private:
+
+    std::vector<std::byte> buffer{};
+};
+
+// The last snapshots, one per tick, to rewind or roll back a few seconds of play.
+// Slots are reused from the oldest, so once the ring is full it stops allocating.
+class SnapshotRing
+{
+public:
+
+    explicit SnapshotRing(int capacity);
+
+    // the slot for the newest snapshot, overwriting the oldest when full
+    Snapshot& push();
+    // 0 is the newest, null if that tick isn't kept
+    [[nodiscard]] const Snapshot* get(int ticksAgo) const;
+    // forgets the newest count snapshots, e.g. after rewinding past them
+    void pop(int count = 1);
+    [[nodiscard]] int size() const;
+
+private:
+
+    std::vector<Snapshot> slots;
+    int newest = -1;
+    int count{};
+};
@@ -0,0 +1,128 @@
+#include "spritebatch.hpp"
+
+#include <algorithm>
+
+SpriteBatch::SpriteBatch(std::pmr::memory_resource* arena, const int expectedSprites)
+    : sprites(arena), vertices(arena), indices(arena)
+{
+    const int perCall = std::min(expectedSprites, MAX_SPRITES_PER_CALL);
+    sprites.reserve(expectedSprites);
+    vertices.reserve(perCall * 4);
+    indices.reserve(perCall * 6);
+}
+
+void SpriteBatch::draw(
+        SDL_Texture* texture, const SDL_FRect& src, const SDL_FRect& dst, const SDL_FlipMode flip,
+        const SDL_FColor color, const int layer, const bool opaque)
+{
+    sprites.push_back(
+            {
+                    .texture = texture, .layer = layer, .opaque = opaque,
+                    .order = static_cast<int>(sprites.size()), .src = src, .dst = dst, .flip = flip,
+                    .color = color
+            });
+}
+
+void SpriteBatch::flush(SDL_Renderer* renderer)
+{
+    stats = {.sprites = static_cast<int>(sprites.size())};
+
+    // layer decides what is on top, texture groups sprites into as few draw calls as possible.
+    // Within a texture opaque sprites go first, so blended ones still end up on top of them.
+    std::ranges::sort(
+            sprites, [](const Sprite& a, const Sprite& b)
+            {
+                if (a.layer != b.layer)
+                {
+                    return a.layer < b.layer;
+                }
+                if (a.texture != b.texture)
+                {
+                    return a.texture < b.texture;
+                }
+                if (a.opaque != b.opaque)
+                {
+                    return a.opaque;
+                }
+                return a.order < b.order;
+            });
+
+    const Sprite* first = sprites.data();
+    const Sprite* end = sprites.data() + sprites.size();
+    while (first != end)
+    {
+        const Sprite* last = first;
+        while (last != end && last->layer == first->layer && last->texture == first->texture &&
+               last->opaque == first->opaque)
+        {
+            ++last;
+        }
+        ++stats.batches;
+        stats.opaque += first->opaque ? static_cast<int>(last - first) : 0;
+
+        for (const Sprite* chunk = first; chunk != last;)
+        {
+            const Sprite* chunkEnd = chunk + std::min<ptrdiff_t>(
+                                             last - chunk, MAX_SPRITES_PER_CALL);
+            emit(renderer, chunk, chunkEnd);
+            chunk = chunkEnd;
+        }
+        first = last;
+    }
+
+    sprites.clear();
+}
+
+const SpriteBatch::Stats& SpriteBatch::getStats() const
+{
+    return stats;
+}
+
+void SpriteBatch::emit(SDL_Renderer* renderer, const Sprite* first, const Sprite* last)
+{
+    vertices.clear();
+    indices.clear();
+
+    SDL_Texture* texture = first->texture;
+    const float texW = static_cast<float>(texture->w);
+    const float texH = static_cast<float>(texture->h);
+    for (const Sprite* s = first; s != last; ++s)
+    {
+        float u0 = s->src.x / texW;
+        float u1 = (s->src.x + s->src.w) / texW;
+        const float v0 = s->src.y / texH;
+        const float v1 = (s->src.y + s->src.h) / texH;
+        if (s->flip == SDL_FLIP_HORIZONTAL)
+        {
+            std::swap(u0, u1);
+        }
+
+        const int base = static_cast<int>(vertices.size());
+        const float x0 = s->dst.x, y0 = s->dst.y;
+        const float x1 = s->dst.x + s->dst.w, y1 = s->dst.y + s->dst.h;
+        vertices.push_back({{x0, y0}, s->color, {u0, v0}});
+        vertices.push_back({{x1, y0}, s->color, {u1, v0}});
+        vertices.push_back({{x1, y1}, s->color, {u1, v1}});
+        vertices.push_back({{x0, y1}, s->color, {u0, v1}});
+        for (const int i: {0, 1, 2, 0, 2, 3})
+        {
+            indices.push_back(base + i);
+        }
+    }
+
+    // the texture keeps its own blend mode for everything else drawn from it
+    SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+    if (first->opaque)
+    {
+        SDL_GetTextureBlendMode(texture, &blendMode);
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+    }
+    SDL_RenderGeometry(
+            renderer, texture, vertices.data(), static_cast<int>(vertices.size()),
+            indices.data(), static_cast<int>(indices.size()));
+    if (first->opaque)
+    {
+        SDL_SetTextureBlendMode(texture, blendMode);
+    }
+    ++stats.drawCalls;
+}
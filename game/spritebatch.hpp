@@ -0,0 +1,55 @@
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include <SDL3/SDL.h>
+
+// Collects every sprite drawn during a frame and renders them sorted by layer and texture,
+// with one SDL_RenderGeometry call per run of sprites sharing a texture.
+// Tinting is done with vertex colours, so textures are never modified. Opaque sprites are
+// drawn without blending, which is a plain copy for the software renderer.
+// It lives for one frame and takes its storage from the frame arena.
+class SpriteBatch
+{
+public:
+
+    struct Stats
+    {
+        int sprites{};   // sprites submitted
+        int opaque{};    // of which drawn without blending
+        int batches{};   // runs of sprites sharing layer and texture
+        int drawCalls{}; // SDL_RenderGeometry calls
+    };
+
+    // sprites in a batch are split into draw calls of at most this size
+    static constexpr int MAX_SPRITES_PER_CALL = 4096;
+
+    // expectedSprites is usually last frame's count, so the storage never has to grow
+    SpriteBatch(std::pmr::memory_resource* arena, int expectedSprites);
+
+    // opaque sprites have no transparent pixels in src and a colour alpha of 1
+    void draw(
+            SDL_Texture* texture, const SDL_FRect& src, const SDL_FRect& dst, SDL_FlipMode flip,
+            SDL_FColor color, int layer, bool opaque = false);
+    void flush(SDL_Renderer* renderer);
+    [[nodiscard]] const Stats& getStats() const;
+
+private:
+
+    struct Sprite
+    {
+        SDL_Texture* texture{};
+        int layer{};
+        bool opaque{};
+        int order{}; // submission order, keeps the sort stable
+        SDL_FRect src{}, dst{};
+        SDL_FlipMode flip{};
+        SDL_FColor color{};
+    };
+
+    std::pmr::vector<Sprite> sprites;
+    std::pmr::vector<SDL_Vertex> vertices;
+    std::pmr::vector<int> indices;
+    Stats stats{};
+
+    void emit(SDL_Renderer* renderer, const Sprite* first, const Sprite* last);
+};
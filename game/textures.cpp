@@ -0,0 +1,112 @@
+#include "textures.hpp"
+
+#include <stdexcept>
+
+SDL_PixelFormat textures::preferredFormat(SDL_Renderer* renderer, const bool alpha)
+{
+    const auto* formats = static_cast<const SDL_PixelFormat*>(SDL_GetPointerProperty(
+            SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER,
+            nullptr));
+    SDL_PixelFormat fallback = SDL_PIXELFORMAT_RGBA32;
+    bool found = false;
+    for (; formats != nullptr && *formats != SDL_PIXELFORMAT_UNKNOWN; ++formats)
+    {
+        // YUV, 10 bit and float formats are for video and HDR, not sprites
+        const SDL_PixelFormat format = *formats;
+        if (SDL_ISPIXELFORMAT_FOURCC(format) || SDL_ISPIXELFORMAT_10BIT(format) ||
+            SDL_ISPIXELFORMAT_FLOAT(format) || SDL_ISPIXELFORMAT_INDEXED(format))
+        {
+            continue;
+        }
+        if (SDL_ISPIXELFORMAT_ALPHA(format) == alpha)
+        {
+            return format;
+        }
+        // an opaque image can go in a format with alpha, not the other way round
+        if (!found && SDL_ISPIXELFORMAT_ALPHA(format))
+        {
+            fallback = format;
+            found = true;
+        }
+    }
+    return fallback;
+}
+
+bool textures::isOpaque(SDL_Surface* surface)
+{
+    if (!SDL_ISPIXELFORMAT_ALPHA(surface->format) && !SDL_ISPIXELFORMAT_INDEXED(surface->format) &&
+        !SDL_SurfaceHasColorKey(surface))
+    {
+        return true;
+    }
+    // palettes and colour keys become alpha here, whatever the image was stored as
+    AutoRelease<SDL_Surface*> rgba = {
+            SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32), SDL_DestroySurface
+    };
+    if (rgba == nullptr)
+    {
+        return false; // blending is never wrong, only slower
+    }
+    const SDL_Surface* pixels = rgba;
+    for (int y = 0; y < pixels->h; ++y)
+    {
+        const auto* row = static_cast<const Uint8*>(pixels->pixels) + y * pixels->pitch;
+        for (int x = 0; x < pixels->w; ++x)
+        {
+            if (row[x * 4 + 3] != 255)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+AutoRelease<SDL_Texture*> textures::create(SDL_Renderer* renderer, SDL_Surface* surface)
+{
+    const bool opaque = isOpaque(surface);
+    AutoRelease<SDL_Texture*> texture = {
+            SDL_CreateTexture(
+                    renderer, preferredFormat(renderer, !opaque), SDL_TEXTUREACCESS_STATIC,
+                    surface->w, surface->h),
+            SDL_DestroyTexture
+    };
+    if (texture == nullptr)
+    {
+        throw std::runtime_error("Failed to create texture");
+    }
+    if (opaque)
+    {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+    }
+    else if (!SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED))
+    {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+
+    AutoRelease<SDL_Surface*> converted = convertFor(texture, surface);
+    const SDL_Surface* pixels = converted;
+    if (!SDL_UpdateTexture(texture, nullptr, pixels->pixels, pixels->pitch))
+    {
+        throw std::runtime_error("Failed to upload texture");
+    }
+    return texture;
+}
+
+AutoRelease<SDL_Surface*> textures::convertFor(SDL_Texture* texture, SDL_Surface* surface)
+{
+    AutoRelease<SDL_Surface*> converted = {
+            SDL_ConvertSurface(surface, texture->format), SDL_DestroySurface
+    };
+    if (converted == nullptr)
+    {
+        throw std::runtime_error("Failed to convert surface");
+    }
+    SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+    SDL_GetTextureBlendMode(texture, &blendMode);
+    if (blendMode == SDL_BLENDMODE_BLEND_PREMULTIPLIED)
+    {
+        SDL_PremultiplySurfaceAlpha(converted, false);
+    }
+    return converted;
+}
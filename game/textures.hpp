@@ -0,0 +1,18 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <autorelease/AutoRelease.hpp>
+
+// Images are uploaded once, in the format the renderer draws from and with premultiplied
+// alpha where it supports it, so drawing never converts pixels. Fully opaque images are
+// stored without alpha and drawn without blending.
+namespace textures
+{
+    // the first format the renderer lists with or without alpha, RGBA32 if there is none
+    [[nodiscard]] SDL_PixelFormat preferredFormat(SDL_Renderer* renderer, bool alpha);
+    // true if no pixel is even partly transparent
+    [[nodiscard]] bool isOpaque(SDL_Surface* surface);
+    // a static texture with the pixels of surface, throws if it can't be made
+    AutoRelease<SDL_Texture*> create(SDL_Renderer* renderer, SDL_Surface* surface);
+    // surface in the format and alpha of texture, ready for SDL_UpdateTexture. Throws on failure.
+    AutoRelease<SDL_Surface*> convertFor(SDL_Texture* texture, SDL_Surface* surface);
+}
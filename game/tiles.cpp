@@ -0,0 +1,80 @@
+#include "tiles.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void TileAnimations::load(
+        const std::span<const tmx::TileSet> tileSets,
+        const std::span<const TileSetTextures> textures)
+{
+    std::unordered_map<int, Sequence> loaded;
+    for (size_t t = 0; t < tileSets.size() && t < textures.size(); ++t)
+    {
+        const std::vector<const AtlasRegion*>& regions = textures[t].textures;
+        for (const tmx::Tile& tile: tileSets[t].tiles)
+        {
+            if (tile.animation.empty())
+            {
+                continue;
+            }
+            Sequence sequence;
+            uint32_t end = 0;
+            for (const auto& [tileId, duration]: tile.animation)
+            {
+                // frames pointing outside the tileset are dropped
+                if (tileId < 0 || tileId >= static_cast<int>(regions.size()))
+                {
+                    continue;
+                }
+                end += std::max(duration, 0);
+                sequence.frames.push_back(regions[tileId]);
+                sequence.ends.push_back(end);
+            }
+            if (!sequence.frames.empty())
+            {
+                loaded.emplace(textures[t].firstgid + tile.id, std::move(sequence));
+            }
+        }
+    }
+
+    // assigned into the existing nodes, tiles of a gid animated before and after keep working
+    std::erase_if(
+            sequences, [&loaded](const auto& entry)
+            {
+                return !loaded.contains(entry.first);
+            });
+    for (auto& [gid, sequence]: loaded)
+    {
+        sequences[gid] = std::move(sequence);
+    }
+    update(0);
+}
+
+void TileAnimations::update(const float deltaTime)
+{
+    remainder += deltaTime * 1000.0f;
+    const float wholeMs = std::floor(remainder);
+    clockMs += static_cast<uint64_t>(wholeMs);
+    remainder -= wholeMs;
+
+    for (auto& [gid, sequence]: sequences)
+    {
+        // every tile of a gid is on the same frame, they all started together
+        const uint32_t loop = sequence.ends.back();
+        const uint32_t time = loop > 0 ? static_cast<uint32_t>(clockMs % loop) : 0;
+        const auto frame = std::ranges::upper_bound(sequence.ends, time) - sequence.ends.begin();
+        // atlas regions change when the atlas is packed again, so the copy is made every time
+        sequence.current = *sequence.frames[std::min<size_t>(frame, sequence.frames.size() - 1)];
+    }
+}
+
+const AtlasRegion* TileAnimations::region(const int gid) const
+{
+    const auto itr = sequences.find(gid);
+    return itr != sequences.end() ? &itr->second.current : nullptr;
+}
+
+size_t TileAnimations::size() const
+{
+    return sequences.size();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "atlas.hpp"
+#include "tmx.hpp"
+
+struct TileSetTextures
+{
+    int firstgid{};
+    std::vector<const AtlasRegion*> textures{};
+};
+
+// Animations from the map's tilesets. Every animated gid has one frame sequence, shared by
+// all the tiles showing it, and one clock drives them all. A tile keeps pointing at the region
+// of its gid here, which update() points at the current frame, so thousands of animated tiles
+// cost one table update per frame and nothing per tile.
+class TileAnimations
+{
+public:
+
+    // the animations of every tileset, gids that stay animated keep their region
+    void load(std::span<const tmx::TileSet> tileSets, std::span<const TileSetTextures> textures);
+    // moves the clock and sets every region to the frame it is on
+    void update(float deltaTime);
+    // what a tile with gid draws, nullptr if gid isn't animated. Valid until a load()
+    // drops gid.
+    [[nodiscard]] const AtlasRegion* region(int gid) const;
+    [[nodiscard]] size_t size() const;
+
+private:
+
+    struct Sequence
+    {
+        std::vector<const AtlasRegion*> frames{};
+        std::vector<uint32_t> ends{}; // milliseconds into the loop each frame ends at
+        AtlasRegion current{};        // copy of the frame shown now
+    };
+
+    // nodes don't move, so the regions handed out stay put when others are added or removed
+    std::unordered_map<int, Sequence> sequences{};
+    uint64_t clockMs{};
+    float remainder{}; // seconds under a millisecond, carried to the next update
+};
@@ -1,125 +1,622 @@
 #include "tmx.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
-#include <sstream>
-#include <tinyxml2.h>
+#include <optional>
+#include <string_view>
+#include <SDL3/SDL.h>
 
-std::unique_ptr<tmx::Map> tmx::loadMap(const std::string& filename)
+#include "pack.hpp"
+
+namespace
 {
-    using namespace tinyxml2;
-    std::filesystem::path path(filename.c_str());
+    // Pull parser reading an XML file front to back through a small buffer, so only the
+    // current tag is ever held in memory and the document tree is never built.
+    // Files come from the asset pack when one is mounted.
+    // It covers what Tiled writes: elements, attributes, text, comments and the declaration.
+    class XmlReader
+    {
+    public:
 
-    auto map = std::make_unique<tmx::Map>();
+        enum class Token
+        {
+            start, end, eof, error
+        };
 
-    XMLDocument doc;
-    doc.LoadFile(path.string().c_str());
-    XMLElement* mapDoc = doc.FirstChildElement("map");
-    if (mapDoc != nullptr)
-    {
-        map->mapWidth = mapDoc->IntAttribute("width");
-        map->mapHeight = mapDoc->IntAttribute("height");
-        map->tileWidth = mapDoc->IntAttribute("tilewidth");
-        map->tileHeight = mapDoc->IntAttribute("tileheight");
+        explicit XmlReader(const std::filesystem::path& path)
+            : file(assets::open(path.string())), buffer(BUFFER_SIZE)
+        {
+        }
 
-        for (XMLElement* child = mapDoc->FirstChildElement();
-             child != nullptr;
-             child = child->NextSiblingElement())
+        ~XmlReader()
         {
-            if (strcmp(child->Name(), "tileset") == 0)
+            if (file != nullptr)
             {
-                int firstgid = child->IntAttribute("firstgid");
+                SDL_CloseIO(file);
+            }
+        }
+
+        XmlReader(const XmlReader&) = delete;
+        XmlReader& operator=(const XmlReader&) = delete;
+
+        [[nodiscard]] bool isOpen() const
+        {
+            return file != nullptr;
+        }
 
-                // load tileset XML
-                XMLDocument tilesetDoc;
-                auto sourcePath = path.parent_path().append(child->Attribute("source"));
-                tilesetDoc.LoadFile(sourcePath.string().c_str());
+        // skips any text and reads the next tag
+        Token next();
 
-                XMLElement* ts = tilesetDoc.FirstChildElement("tileset");
-                if (ts != nullptr)
+        [[nodiscard]] const std::string& name() const
+        {
+            return tagName;
+        }
+
+        // <tag/>, no end token follows it
+        [[nodiscard]] bool isEmpty() const
+        {
+            return emptyTag;
+        }
+
+        // attributes of the last start tag, nullptr or 0 if missing
+        [[nodiscard]] const char* attribute(std::string_view attributeName) const;
+        [[nodiscard]] int intAttribute(std::string_view attributeName) const;
+        [[nodiscard]] float floatAttribute(std::string_view attributeName) const;
+
+        // appends the text up to the next tag, read as comma separated integers
+        bool readCsv(std::vector<int>& values);
+
+    private:
+
+        static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+        struct Attribute
+        {
+            std::string name, value;
+        };
+
+        SDL_IOStream* file;
+        std::vector<char> buffer;
+        size_t position{}, size{};
+        std::string tagName{};
+        bool emptyTag{};
+        // reused from tag to tag, once the strings have grown reading a tag doesn't allocate
+        std::vector<Attribute> attributes{};
+        size_t attributeCount{};
+
+        int peek()
+        {
+            if (position == size)
+            {
+                size = SDL_ReadIO(file, buffer.data(), buffer.size());
+                position = 0;
+                if (size == 0)
                 {
-                    int tileWidth = ts->IntAttribute("tilewidth");
-                    int tileHeight = ts->IntAttribute("tileheight");
-                    int count = ts->IntAttribute("tilecount");
-                    int columns = ts->IntAttribute("columns");
-                    tmx::TileSet newTileSet(firstgid, count, tileWidth, tileHeight, columns);
+                    return EOF;
+                }
+            }
+            return static_cast<unsigned char>(buffer[position]);
+        }
 
-                    for (XMLElement* tile = ts->FirstChildElement("tile");
-                         tile != nullptr;
-                         tile = tile->NextSiblingElement("tile"))
-                    {
-                        tmx::Tile newTile;
-                        newTile.id = tile->IntAttribute("id");
-
-                        XMLElement* image = tile->FirstChildElement("image");
-                        if (image != nullptr)
-                        {
-                            newTile.image.source = image->Attribute("source");
-                            newTile.image.width = image->IntAttribute("width");
-                            newTile.image.height = image->IntAttribute("height");
-                        }
-                        newTileSet.tiles.push_back(std::move(newTile));
-                    }
-                    assert(newTileSet.count == newTileSet.tiles.size());
+        int get()
+        {
+            const int c = peek();
+            if (c != EOF)
+            {
+                ++position;
+            }
+            return c;
+        }
+
+        void skipSpace();
+        bool skipPast(std::string_view terminator);
+        bool readName(std::string& out);
+        bool readAttributeValue(std::string& out);
+    };
 
-                    map->tileSets.push_back(std::move(newTileSet));
+    XmlReader::Token XmlReader::next()
+    {
+        for (;;)
+        {
+            int c;
+            while ((c = get()) != '<')
+            {
+                if (c == EOF)
+                {
+                    return Token::eof;
                 }
             }
-            else if (strcmp(child->Name(), "layer") == 0)
+
+            // <?xml ...?> and <!-- ... -->
+            c = peek();
+            if (c == '?' || c == '!')
             {
-                tmx::Layer layer;
-                layer.name = child->Attribute("name");
-                layer.id = child->IntAttribute("id");
-                layer.data.reserve(map->mapWidth * map->mapHeight);
+                get();
+                const bool comment = peek() == '-';
+                if (!skipPast(c == '?' ? "?>" : comment ? "-->" : ">"))
+                {
+                    return Token::error;
+                }
+                continue;
+            }
 
-                // CSV
-                XMLElement* data = child->FirstChildElement("data");
-                std::stringstream dataStream(data->GetText());
-                for (int i; dataStream >> i;)
+            const bool closing = c == '/';
+            if (closing)
+            {
+                get();
+            }
+            if (!readName(tagName))
+            {
+                return Token::error;
+            }
+            attributeCount = 0;
+            emptyTag = false;
+            for (;;)
+            {
+                skipSpace();
+                c = get();
+                if (c == '>')
                 {
-                    layer.data.push_back(i);
-                    if (dataStream.peek() == ',')
-                    {
-                        dataStream.ignore();
-                    }
+                    return closing ? Token::end : Token::start;
                 }
+                if (c == '/')
+                {
+                    emptyTag = true;
+                    return get() == '>' && !closing ? Token::start : Token::error;
+                }
+                if (closing || c == EOF)
+                {
+                    return Token::error;
+                }
+                --position; // c is the first character of the attribute name
 
-                map->layers.emplace_back(std::move(layer));
+                if (attributeCount == attributes.size())
+                {
+                    attributes.emplace_back();
+                }
+                Attribute& attr = attributes[attributeCount++];
+                if (!readName(attr.name))
+                {
+                    return Token::error;
+                }
+                skipSpace();
+                if (get() != '=')
+                {
+                    return Token::error;
+                }
+                skipSpace();
+                if (!readAttributeValue(attr.value))
+                {
+                    return Token::error;
+                }
             }
-            else if (strcmp(child->Name(), "objectgroup") == 0)
+        }
+    }
+
+    const char* XmlReader::attribute(const std::string_view attributeName) const
+    {
+        for (size_t i = 0; i < attributeCount; ++i)
+        {
+            if (attributes[i].name == attributeName)
             {
-                tmx::ObjectGroup layer;
-                layer.name = child->Attribute("name");
-                layer.id = child->IntAttribute("id");
+                return attributes[i].value.c_str();
+            }
+        }
+        return nullptr;
+    }
+
+    int XmlReader::intAttribute(const std::string_view attributeName) const
+    {
+        const char* value = attribute(attributeName);
+        return value != nullptr ? std::atoi(value) : 0;
+    }
+
+    float XmlReader::floatAttribute(const std::string_view attributeName) const
+    {
+        const char* value = attribute(attributeName);
+        return value != nullptr ? std::strtof(value, nullptr) : 0.0f;
+    }
 
-                for (XMLElement* elem = child->FirstChildElement("object");
-                     elem != nullptr;
-                     elem = elem->NextSiblingElement())
+    bool XmlReader::readCsv(std::vector<int>& values)
+    {
+        // gids are unsigned, the top bits hold the flip flags
+        uint32_t value = 0;
+        bool inNumber = false;
+        for (int c; (c = peek()) != '<'; ++position)
+        {
+            if (c >= '0' && c <= '9')
+            {
+                value = value * 10 + (c - '0');
+                inNumber = true;
+            }
+            else if (c == ',' || std::isspace(c))
+            {
+                if (inNumber)
                 {
-                    tmx::LayerObject obj;
-                    obj.id = elem->IntAttribute("id");
-                    obj.x = elem->FloatAttribute("x");
-                    obj.y = elem->FloatAttribute("y");
+                    values.push_back(static_cast<int>(value));
+                    value = 0;
+                    inNumber = false;
+                }
+            }
+            else
+            {
+                return false; // EOF or not CSV
+            }
+        }
+        if (inNumber)
+        {
+            values.push_back(static_cast<int>(value));
+        }
+        return true;
+    }
+
+    void XmlReader::skipSpace()
+    {
+        while (std::isspace(peek()))
+        {
+            get();
+        }
+    }
+
+    bool XmlReader::skipPast(const std::string_view terminator)
+    {
+        std::string tail; // short enough to never allocate
+        for (int c; (c = get()) != EOF;)
+        {
+            if (tail.size() == terminator.size())
+            {
+                tail.erase(0, 1);
+            }
+            tail.push_back(static_cast<char>(c));
+            if (tail == terminator)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool XmlReader::readName(std::string& out)
+    {
+        out.clear();
+        for (int c = peek(); c != EOF && !std::isspace(c) && c != '=' && c != '/' && c != '>';
+             c = peek())
+        {
+            out.push_back(static_cast<char>(get()));
+        }
+        return !out.empty();
+    }
 
-                    const char* attrName = elem->Attribute("name");
-                    if (attrName != nullptr)
+    bool XmlReader::readAttributeValue(std::string& out)
+    {
+        out.clear();
+        const int quote = get();
+        if (quote != '"' && quote != '\'')
+        {
+            return false;
+        }
+        for (int c; (c = get()) != quote;)
+        {
+            if (c == EOF)
+            {
+                return false;
+            }
+            if (c == '&')
+            {
+                std::string entity;
+                while ((c = get()) != ';')
+                {
+                    if (c == EOF || entity.size() > 8)
                     {
-                        obj.name = attrName;
+                        return false;
                     }
-
-                    const char* attrType = elem->Attribute("type");
-                    if (attrType != nullptr)
+                    entity.push_back(static_cast<char>(c));
+                }
+                if (entity == "lt")
+                {
+                    c = '<';
+                }
+                else if (entity == "gt")
+                {
+                    c = '>';
+                }
+                else if (entity == "amp")
+                {
+                    c = '&';
+                }
+                else if (entity == "quot")
+                {
+                    c = '"';
+                }
+                else if (entity == "apos")
+                {
+                    c = '\'';
+                }
+                else if (entity.starts_with('#'))
+                {
+                    // only ASCII is ever escaped this way, e.g. &#10; in multi-line values
+                    c = entity.starts_with("#x")
+                            ? std::strtol(entity.c_str() + 2, nullptr, 16)
+                            : std::atoi(entity.c_str() + 1);
+                    if (c <= 0 || c > 127)
                     {
-                        obj.type = attrType;
+                        return false;
                     }
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            out.push_back(static_cast<char>(c));
+        }
+        return true;
+    }
+
+    // reads the tileset tag the reader is on, up to its end tag
+    std::optional<tmx::TileSet> readTileSet(XmlReader& reader, const int firstgid)
+    {
+        tmx::TileSet tileSet(
+                firstgid, reader.intAttribute("tilecount"), reader.intAttribute("tilewidth"),
+                reader.intAttribute("tileheight"), reader.intAttribute("columns"));
+        if (reader.isEmpty())
+        {
+            return tileSet;
+        }
+        tileSet.tiles.reserve(tileSet.count);
 
-                    layer.objects.push_back(std::move(obj));
+        bool inTile = false;
+        for (XmlReader::Token token; (token = reader.next()) != XmlReader::Token::eof;)
+        {
+            const std::string& name = reader.name();
+            if (token == XmlReader::Token::error)
+            {
+                break;
+            }
+            if (token == XmlReader::Token::end)
+            {
+                if (name == "tileset")
+                {
+                    assert(tileSet.count == static_cast<int>(tileSet.tiles.size()));
+                    return tileSet;
+                }
+                inTile = inTile && name != "tile";
+            }
+            else if (name == "tile")
+            {
+                tileSet.tiles.push_back({.id = reader.intAttribute("id")});
+                inTile = !reader.isEmpty();
+            }
+            else if (name == "image" && inTile)
+            {
+                tmx::Image& image = tileSet.tiles.back().image;
+                if (const char* source = reader.attribute("source"))
+                {
+                    image.source = source;
                 }
+                image.width = reader.intAttribute("width");
+                image.height = reader.intAttribute("height");
+            }
+            else if (name == "frame" && inTile)
+            {
+                tileSet.tiles.back().animation.push_back(
+                        {reader.intAttribute("tileid"), reader.intAttribute("duration")});
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string nameAttribute(const XmlReader& reader)
+    {
+        const char* name = reader.attribute("name");
+        return name != nullptr ? name : "";
+    }
+}
+
+const tmx::TileSet* tmx::TileSetCache::get(const std::string& filename)
+{
+    if (const auto itr = tileSets.find(filename); itr != tileSets.end())
+    {
+        return &itr->second;
+    }
+
+    XmlReader reader(filename);
+    if (!reader.isOpen())
+    {
+        return nullptr;
+    }
+    XmlReader::Token token;
+    while ((token = reader.next()) == XmlReader::Token::start && reader.name() != "tileset")
+    {
+    }
+    if (token != XmlReader::Token::start)
+    {
+        return nullptr;
+    }
+    std::optional<TileSet> tileSet = readTileSet(reader, 0);
+    if (!tileSet)
+    {
+        return nullptr;
+    }
+    return &tileSets.emplace(filename, std::move(*tileSet)).first->second;
+}
+
+void tmx::TileSetCache::erase(const std::string& filename)
+{
+    tileSets.erase(filename);
+}
+
+void tmx::TileSetCache::clear()
+{
+    tileSets.clear();
+}
+
+std::unique_ptr<tmx::Map> tmx::loadMap(const std::string& filename, TileSetCache& tileSetCache)
+{
+    const std::filesystem::path path(filename);
+    XmlReader reader(path);
+    if (!reader.isOpen())
+    {
+        return nullptr;
+    }
+
+    auto map = std::make_unique<tmx::Map>();
+    // the layer or object group whose children are being read
+    tmx::Layer* layer = nullptr;
+    tmx::ObjectGroup* objectGroup = nullptr;
+    tmx::ImageLayer* imageLayer = nullptr;
+    // where <property> tags go, the innermost layer, object group or object
+    std::vector<Property>* properties = nullptr;
+    for (XmlReader::Token token; (token = reader.next()) != XmlReader::Token::eof;)
+    {
+        if (token == XmlReader::Token::error)
+        {
+            return nullptr;
+        }
+        const std::string& name = reader.name();
+        if (token == XmlReader::Token::end)
+        {
+            if (name == "layer" || name == "objectgroup" || name == "imagelayer")
+            {
+                layer = nullptr;
+                objectGroup = nullptr;
+                imageLayer = nullptr;
+                properties = nullptr;
+            }
+            else if (name == "object" && objectGroup != nullptr)
+            {
+                properties = &objectGroup->properties;
+            }
+            continue;
+        }
 
-                map->layers.emplace_back(std::move(layer));
+        if (name == "map")
+        {
+            map->mapWidth = reader.intAttribute("width");
+            map->mapHeight = reader.intAttribute("height");
+            map->tileWidth = reader.intAttribute("tilewidth");
+            map->tileHeight = reader.intAttribute("tileheight");
+        }
+        else if (name == "tileset")
+        {
+            const int firstgid = reader.intAttribute("firstgid");
+            if (const char* source = reader.attribute("source"))
+            {
+                // external tileset, relative to the map, keyed by the generic path the watcher
+                // reports so a reload finds it on Windows too
+                const TileSet* tileSet = tileSetCache.get(
+                        (path.parent_path() / source).lexically_normal().generic_string());
+                if (tileSet == nullptr)
+                {
+                    return nullptr;
+                }
+                map->tileSets.push_back(*tileSet);
+                map->tileSets.back().firstgid = firstgid;
+            }
+            else
+            {
+                std::optional<TileSet> tileSet = readTileSet(reader, firstgid);
+                if (!tileSet)
+                {
+                    return nullptr;
+                }
+                map->tileSets.push_back(std::move(*tileSet));
+            }
+        }
+        else if (name == "layer")
+        {
+            layer = &std::get<tmx::Layer>(map->layers.emplace_back(std::in_place_type<Layer>));
+            layer->name = nameAttribute(reader);
+            layer->id = reader.intAttribute("id");
+            layer->data.reserve(map->mapWidth * map->mapHeight);
+            properties = &layer->properties;
+        }
+        else if (name == "data" && layer != nullptr && !reader.isEmpty())
+        {
+            // CSV is parsed straight into the layer
+            const char* encoding = reader.attribute("encoding");
+            if (encoding == nullptr || std::string_view(encoding) != "csv" ||
+                !reader.readCsv(layer->data))
+            {
+                return nullptr;
+            }
+        }
+        else if (name == "objectgroup")
+        {
+            objectGroup = &std::get<tmx::ObjectGroup>(
+                    map->layers.emplace_back(std::in_place_type<ObjectGroup>));
+            objectGroup->name = nameAttribute(reader);
+            objectGroup->id = reader.intAttribute("id");
+            properties = &objectGroup->properties;
+        }
+        else if (name == "object" && objectGroup != nullptr)
+        {
+            tmx::LayerObject& obj = objectGroup->objects.emplace_back();
+            obj.id = reader.intAttribute("id");
+            obj.x = reader.floatAttribute("x");
+            obj.y = reader.floatAttribute("y");
+            obj.name = nameAttribute(reader);
+            if (const char* type = reader.attribute("type"))
+            {
+                obj.type = type;
+            }
+            // an empty tag has no end tag to hand the properties back to the group
+            if (!reader.isEmpty())
+            {
+                properties = &obj.properties;
+            }
+        }
+        else if (name == "imagelayer")
+        {
+            tmx::ImageLayer& added = map->imageLayers.emplace_back();
+            added.name = nameAttribute(reader);
+            added.id = reader.intAttribute("id");
+            added.offsetY = reader.floatAttribute("offsety");
+            // left out by Tiled when it is 1
+            if (reader.attribute("parallaxx") != nullptr)
+            {
+                added.parallaxX = reader.floatAttribute("parallaxx");
             }
+            // an empty tag has no image and no end tag
+            if (!reader.isEmpty())
+            {
+                imageLayer = &added;
+                properties = &added.properties;
+            }
+        }
+        else if (name == "image" && imageLayer != nullptr)
+        {
+            if (const char* source = reader.attribute("source"))
+            {
+                imageLayer->image.source = source;
+            }
+            imageLayer->image.width = reader.intAttribute("width");
+            imageLayer->image.height = reader.intAttribute("height");
+        }
+        else if (name == "property" && properties != nullptr)
+        {
+            const char* value = reader.attribute("value");
+            properties->push_back({nameAttribute(reader), value != nullptr ? value : ""});
         }
     }
 
     return map;
 }
+
+const std::string* tmx::findProperty(
+        const std::vector<Property>& properties, const std::string_view name)
+{
+    const auto itr = std::ranges::find(properties, name, &Property::name);
+    return itr != properties.end() ? &itr->value : nullptr;
+}
+
+std::unique_ptr<tmx::Map> tmx::loadMap(const std::string& filename)
+{
+    TileSetCache tileSetCache;
+    return loadMap(filename, tileSetCache);
+}
@@ -1,16 +1,32 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 namespace tmx
 {
+    // a custom property set in Tiled, its value kept as text whatever its type
+    struct Property
+    {
+        std::string name{}, value{};
+
+        bool operator==(const Property&) const = default;
+    };
+
+    // the value of the property called name, nullptr if there is none
+    const std::string* findProperty(const std::vector<Property>& properties, std::string_view name);
+
     struct Layer
     {
         int id{};
         std::string name{};
         std::vector<int> data{}; // CSV
+        std::vector<Property> properties{};
+
+        bool operator==(const Layer&) const = default;
     };
 
     struct LayerObject
@@ -20,6 +36,9 @@ namespace tmx
         std::string type{};
         float x{};
         float y{};
+        std::vector<Property> properties{};
+
+        bool operator==(const LayerObject&) const = default;
     };
 
     struct ObjectGroup
@@ -27,18 +46,49 @@ namespace tmx
         int id{};
         std::string name{};
         std::vector<LayerObject> objects{};
+        std::vector<Property> properties{};
+
+        bool operator==(const ObjectGroup&) const = default;
     };
 
     struct Image
     {
         std::string source{};
         int width{}, height{};
+
+        bool operator==(const Image&) const = default;
+    };
+
+    // a picture drawn behind the map, Tiled's parallaxx is the fraction of the camera movement
+    // it scrolls by
+    struct ImageLayer
+    {
+        int id{};
+        std::string name{};
+        Image image{}; // source relative to the map
+        float offsetY{};
+        float parallaxX = 1;
+        std::vector<Property> properties{};
+
+        bool operator==(const ImageLayer&) const = default;
+    };
+
+    // one step of a tile animation
+    struct Frame
+    {
+        int tileId{};   // tile shown, in the same tileset
+        int duration{}; // milliseconds
+
+        bool operator==(const Frame&) const = default;
     };
 
     struct Tile
     {
         int id{};
         Image image{};
+        std::vector<Frame> animation{}; // empty unless the tile is animated
+
+        bool operator==(const Tile&) const = default;
     };
 
     struct TileSet
@@ -53,6 +103,8 @@ namespace tmx
               firstgid(firstgid)
         {
         }
+
+        bool operator==(const TileSet&) const = default;
     };
 
     struct Map
@@ -61,7 +113,27 @@ namespace tmx
         int tileWidth{}, tileHeight{};
         std::vector<TileSet> tileSets{};
         std::vector<std::variant<Layer, ObjectGroup>> layers{};
+        // kept apart from layers, which become the game's object layers, back to front
+        std::vector<ImageLayer> imageLayers{};
+    };
+
+    // Tilesets read from .tsx files, kept by path so maps sharing one only parse it once
+    class TileSetCache
+    {
+    public:
+
+        // firstgid is left at 0, nullptr if the file can't be read
+        const TileSet* get(const std::string& filename);
+        // the next get() reads the file again
+        void erase(const std::string& filename);
+        void clear();
+
+    private:
+
+        std::unordered_map<std::string, TileSet> tileSets{};
     };
 
+    // nullptr if the map or one of its tilesets can't be read
+    std::unique_ptr<Map> loadMap(const std::string& filename, TileSetCache& tileSetCache);
     std::unique_ptr<Map> loadMap(const std::string& filename);
 }
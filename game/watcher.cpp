@@ -0,0 +1,167 @@
+#include "watcher.hpp"
+
+#include <algorithm>
+#include <SDL3/SDL.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace
+{
+    void addChanged(std::vector<std::string>& changed, std::string path)
+    {
+        if (std::ranges::find(changed, path) == changed.end())
+        {
+            changed.push_back(std::move(path));
+        }
+    }
+}
+
+#ifdef __linux__
+
+FileWatcher::~FileWatcher()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool FileWatcher::watch(const std::string& directory)
+{
+    if (fd < 0)
+    {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        buffer.resize(64 * 1024);
+    }
+    const size_t watched = directories.size();
+    addWatches(directory);
+    return directories.size() > watched;
+}
+
+void FileWatcher::addWatches(const std::filesystem::path& directory)
+{
+    // files are reported once they are closed after writing or moved in, editors that save
+    // to a temporary file and rename it end up as IN_MOVED_TO
+    const int wd = inotify_add_watch(
+            fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+    if (wd < 0)
+    {
+        SDL_Log("Can't watch %s", directory.c_str());
+        return;
+    }
+    directories[wd] = directory.generic_string();
+
+    std::error_code ec;
+    for (const auto& entry: std::filesystem::directory_iterator(directory, ec))
+    {
+        if (entry.is_directory(ec))
+        {
+            addWatches(entry.path());
+        }
+    }
+}
+
+const std::vector<std::string>& FileWatcher::poll()
+{
+    changed.clear();
+    if (fd < 0)
+    {
+        return changed;
+    }
+
+    ssize_t length;
+    while ((length = read(fd, buffer.data(), buffer.size())) > 0)
+    {
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const auto itr = directories.find(event->wd);
+            if (itr == directories.end() || event->len == 0)
+            {
+                continue;
+            }
+            std::string path = itr->second + '/' + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                // new directories are watched too, files written in them are reported later
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    addWatches(path);
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                addChanged(changed, std::move(path));
+            }
+        }
+    }
+    return changed;
+}
+
+#else
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::watch(const std::string& directory)
+{
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory, ec))
+    {
+        return false;
+    }
+    root = directory;
+    scan(false);
+    lastScan = SDL_GetTicks();
+    return true;
+}
+
+void FileWatcher::scan(const bool report)
+{
+    std::error_code ec;
+    for (const auto& entry: std::filesystem::recursive_directory_iterator(root, ec))
+    {
+        if (!entry.is_regular_file(ec))
+        {
+            continue;
+        }
+        const std::filesystem::file_time_type writeTime = entry.last_write_time(ec);
+        if (ec)
+        {
+            continue;
+        }
+        std::string path = entry.path().generic_string();
+        // new files count as changed, they may be the rename of a saved file
+        auto [itr, inserted] = writeTimes.try_emplace(path, writeTime);
+        if (inserted || itr->second != writeTime)
+        {
+            itr->second = writeTime;
+            if (report)
+            {
+                addChanged(changed, std::move(path));
+            }
+        }
+    }
+}
+
+const std::vector<std::string>& FileWatcher::poll()
+{
+    changed.clear();
+    if (root.empty() || SDL_GetTicks() - lastScan < SCAN_INTERVAL_MS)
+    {
+        return changed;
+    }
+    lastScan = SDL_GetTicks();
+    scan(true);
+    return changed;
+}
+
+#endif
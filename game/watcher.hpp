@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files that were written under a directory, so assets can be reloaded while the
+// game runs. Uses inotify on Linux; elsewhere the directory is scanned for changed
+// modification times a couple of times per second.
+class FileWatcher
+{
+public:
+
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    ~FileWatcher();
+
+    // watches directory and everything below it, false if it can't be watched
+    bool watch(const std::string& directory);
+    // paths written since the last call, e.g. "data/maps/original.tmx", each listed once.
+    // The vector is reused by the next call.
+    const std::vector<std::string>& poll();
+
+private:
+
+    // editors save in bursts, a scan more often than this would only cost time
+    static constexpr uint64_t SCAN_INTERVAL_MS = 500;
+
+    std::vector<std::string> changed{};
+#ifdef __linux__
+    int fd = -1;
+    std::unordered_map<int, std::string> directories{}; // by watch descriptor
+    std::vector<char> buffer{};
+
+    void addWatches(const std::filesystem::path& directory);
+#else
+    std::string root{};
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes{};
+    uint64_t lastScan{};
+
+    void scan(bool report);
+#endif
+};